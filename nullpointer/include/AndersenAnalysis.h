@@ -0,0 +1,140 @@
+#ifndef ANDERSEN_ANALYSIS_H
+#define ANDERSEN_ANALYSIS_H
+
+#include "PointerAnalysis.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+namespace dataflow {
+
+/**
+ * @brief Inclusion-based (Andersen) pointer analysis.
+ *
+ * The constraints are solved over a graph whose nodes are the pointer nodes
+ * of the function and the contents of each site, with a worklist that
+ * propagates only the new part of each points-to set. Cycles of copy edges
+ * are collapsed into one node when they are found. Sets are updated through
+ * the cache, whose memoized unions make repeated propagations of the same
+ * sets a lookup.
+ */
+class AndersenAnalysis : public PointerAnalysis {
+ public:
+  /**
+   * @brief Build a points-to graph
+   *
+   * This constructor collects the constraints of every instruction in
+   * function F and solves them.
+   *
+   * @param F The function for which pointer analysis is done
+   * @param Index Value numbering of F
+   * @param Threads Number of threads solving the constraints
+   */
+  AndersenAnalysis(Function &F, const ValueIndex &Index, unsigned Threads = 1);
+
+ protected:
+  SetRef pointsToNode(unsigned N) const override { return Nodes[Nodes[N].Rep].Pts; }
+
+  SetRef contents(unsigned Site) const override {
+    return Nodes[Nodes[contentsNode(Site)].Rep].Pts;
+  }
+
+ private:
+  /**
+   * @brief A node of the constraint graph. Its sets are handles into Cache,
+   * so comparing two of them is a pointer comparison.
+   */
+  struct Node {
+    // Representative of the cycle this node was collapsed into.
+    unsigned Rep;
+    SetRef Pts;
+    // The part of Pts already propagated to the successors of the node.
+    SetRef Done;
+    // The part of Pts whose load and store edges were added, when solving
+    // in parallel.
+    SetRef Resolved;
+    // Nodes whose points-to set includes Pts.
+    std::vector<unsigned> Copies;
+    // Nodes L loaded through this one: L = *this.
+    std::vector<unsigned> Loads;
+    // Nodes R stored through this one: *this = R.
+    std::vector<unsigned> Stores;
+  };
+
+  /**
+   * @brief Pointer nodes followed by the contents of every site.
+   */
+  std::vector<Node> Nodes;
+
+  /**
+   * @brief Copy edges between representatives, and the ones already searched
+   * for a cycle.
+   */
+  DenseSet<std::pair<unsigned, unsigned>> Edges;
+  DenseSet<std::pair<unsigned, unsigned>> Checked;
+
+  /**
+   * @brief Nodes whose points-to set grew since they were last visited, in
+   * FIFO order.
+   */
+  std::deque<unsigned> Pending;
+  BitVector Queued;
+
+  unsigned contentsNode(unsigned Site) const { return NumNodes + Site; }
+
+  /**
+   * @brief Propagate points-to sets until no constraint adds a site.
+   */
+  void solve();
+
+  /**
+   * @brief Solve the constraints by wave propagation on Threads threads.
+   *
+   * Each round collapses every cycle of copy edges, propagates the new sites
+   * along the now acyclic graph in topological waves, the nodes of a wave in
+   * parallel, and then adds the edges of the load and store constraints,
+   * until no set grows. Every parallel step writes to distinct nodes only, so
+   * the result does not depend on the schedule.
+   */
+  void solveInParallel(unsigned Threads);
+
+  void push(unsigned N);
+  unsigned find(unsigned N);
+
+  /**
+   * @brief Add the copy edge From -> To between the representatives of the
+   * two nodes, and flow the points-to set of From into To.
+   */
+  void addEdge(unsigned From, unsigned To);
+
+  /**
+   * @brief Collapse the cycles of copy edges reachable from Root.
+   *
+   * @param Root The node to search from
+   * @param DFN Numbers of the nodes visited, also by earlier searches
+   * @param Order If not null, receives the representative of every
+   * component completed, in reverse topological order
+   * @return true if a node was merged.
+   */
+  bool collapseCycles(
+      unsigned Root, DenseMap<unsigned, unsigned> &DFN, std::vector<unsigned> *Order = nullptr);
+
+  /**
+   * @brief Add the sites of Pts to the set of node N.
+   *
+   * @return true if the set of N grew.
+   */
+  bool flowInto(unsigned N, SetRef Pts);
+
+  /**
+   * @brief Merge node From into node Into.
+   */
+  void merge(unsigned Into, unsigned From);
+};
+
+}  // namespace dataflow
+
+#endif  // ANDERSEN_ANALYSIS_H
@@ -0,0 +1,380 @@
+#ifndef DATAFLOW_ENGINE_H
+#define DATAFLOW_ENGINE_H
+
+#include "FunctionIndex.h"
+#include "WeakTopologicalOrder.h"
+#include "Worklist.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/IR/Instruction.h"
+
+#include <utility>
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Dataflow Engine
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Forward dataflow fixpoint over the blocks of a function, shared by
+ * the analyses.
+ *
+ * Lattice is the abstract memory and its operations:
+ *
+ *   using Memory = ...;
+ *   Memory join(const Memory &A, const Memory &B) const;
+ *   bool equal(const Memory &A, const Memory &B) const;
+ *   // Only for RecursiveIteration:
+ *   Memory widen(const Memory &Old, const Memory &New) const;
+ *   Memory narrow(const Memory &Old, const Memory &New) const;
+ *
+ * Transfer is the analysis, which gives the semantics of the instructions:
+ *
+ *   // In memory of the entry block, from an empty one.
+ *   void entry(Memory &In);
+ *   // Refine the Out memory of block Pred for its edge to block B; false if
+ *   // the edge is infeasible.
+ *   bool edge(unsigned Pred, unsigned B, Memory &Mem);
+ *   // Update Out, a copy of In, with the effect of I.
+ *   void transfer(Instruction *I, const Memory *In, Memory &Out);
+ *
+ * Both are template parameters, so their calls are resolved at compile time
+ * and inlined into the fixpoint loop. Memory is the state storage: the engine
+ * only copies, moves and clears it, so any value type with cheap copies fits.
+ *
+ * Only the Out memory of every block is kept. The memories of the
+ * instructions are rebuilt from them by inState() and outState(), one block
+ * at a time. The iteration order is the strategy given to solve():
+ * ChaoticIteration pops blocks from a worklist, and RecursiveIteration
+ * stabilizes the components of a weak topological order with widening.
+ */
+template <typename Lattice, typename Transfer> class DataflowEngine {
+ public:
+  using Memory = typename Lattice::Memory;
+
+  DataflowEngine(const FunctionIndex &Graph, Lattice L, Transfer &T)
+      : Graph(Graph), L(std::move(L)), T(T) {}
+
+  /**
+   * @brief Compute the fixpoint from scratch in the order of Strategy.
+   */
+  template <typename Strategy> void solve(const Strategy &S) {
+    CachedBlock = ~0u;
+    BlockVisits = 0;
+    InstVisits = 0;
+    OutStates.assign(Graph.blocks(), Memory());
+    HeadIn.assign(Graph.blocks(), Memory());
+    Heads.assign(Graph.blocks(), false);
+    Evaluated.assign(Graph.blocks(), Strategy::FlowsInitialOut);
+    S.run(*this);
+  }
+
+  const FunctionIndex &graph() const { return Graph; }
+
+  const Lattice &lattice() const { return L; }
+
+  /**
+   * @brief Does the Out memory of block B flow to its successors? After
+   * solve(), false if no feasible edge leads into B: RecursiveIteration never
+   * evaluates such a block, and ChaoticIteration, which starts with every
+   * block flowing, clears it when it updates B with every edge into it
+   * infeasible. The entry block always flows.
+   */
+  bool evaluated(unsigned B) const { return Evaluated[B]; }
+
+  unsigned blockVisits() const { return BlockVisits; }
+  unsigned instVisits() const { return InstVisits; }
+
+  /**
+   * @brief Join the Out memories of the predecessors of block B into In, an
+   * empty memory, each refined for its edge to B. Predecessors that were not
+   * evaluated are Bottom and skipped.
+   *
+   * @return false if no edge into B is feasible.
+   */
+  bool flowIn(unsigned B, Memory &In) {
+    if (B == 0) {
+      T.entry(In);
+      return true;
+    }
+
+    bool Reachable = false;
+    for (unsigned Pred : Graph.blockPredecessors(B)) {
+      if (!Evaluated[Pred])
+        continue;
+      Memory Edge = OutStates[Pred];
+      if (!T.edge(Pred, B, Edge))
+        continue;
+      if (Reachable) {
+        In = L.join(In, Edge);
+      } else {
+        In = std::move(Edge);
+        Reachable = true;
+      }
+    }
+    return Reachable;
+  }
+
+  /**
+   * @brief Evaluate block B from its predecessors and store its Out memory.
+   * An infeasible block gets an empty (Bottom) Out memory and stops flowing.
+   *
+   * @return true if the Out memory of B changed, or whether it flows.
+   */
+  bool update(unsigned B) {
+    ++BlockVisits;
+    InstVisits += Graph.blockEnd(B) - Graph.blockBegin(B);
+
+    Memory Mem;
+    bool Reachable = flowIn(B, Mem);
+    if (Reachable)
+      transferBlock(B, Mem, false);
+    if (Evaluated[B] == Reachable && L.equal(OutStates[B], Mem))
+      return false;
+    Evaluated[B] = Reachable;
+    OutStates[B] = std::move(Mem);
+    return true;
+  }
+
+  /**
+   * @brief Evaluate block B from In and store its Out memory; an unreachable
+   * block is marked as not evaluated instead.
+   */
+  void evaluate(unsigned B, Memory In, bool Reachable) {
+    Evaluated[B] = Reachable;
+    if (!Reachable) {
+      OutStates[B].clear();
+      return;
+    }
+
+    ++BlockVisits;
+    InstVisits += Graph.blockEnd(B) - Graph.blockBegin(B);
+
+    transferBlock(B, In, false);
+    OutStates[B] = std::move(In);
+  }
+
+  /**
+   * @brief The In memory kept for block B, a head whose In is widened
+   * instead of joined from its predecessors.
+   */
+  Memory &headIn(unsigned B) {
+    Heads[B] = true;
+    return HeadIn[B];
+  }
+
+  /**
+   * @brief Get the In Memory of instruction N at the fixpoint.
+   *
+   * The memories of the block containing N are recomputed from the Out
+   * memories of its predecessors and cached until another block is requested.
+   */
+  const Memory &inState(unsigned N) {
+    unsigned B = Graph.block(N);
+    replay(B);
+    return InCache[N - Graph.blockBegin(B)];
+  }
+
+  /**
+   * @brief Get the Out Memory of instruction N at the fixpoint.
+   */
+  const Memory &outState(unsigned N) {
+    unsigned B = Graph.block(N);
+    replay(B);
+    return OutCache[N - Graph.blockBegin(B)];
+  }
+
+ private:
+  const FunctionIndex &Graph;
+  Lattice L;
+  Transfer &T;
+
+  // Out memory of the terminator of every block, by block number.
+  std::vector<Memory> OutStates;
+  std::vector<Memory> HeadIn;
+  std::vector<bool> Heads;
+  std::vector<bool> Evaluated;
+
+  unsigned BlockVisits = 0;
+  unsigned InstVisits = 0;
+
+  // Memories of the instructions of block CachedBlock, from its first one.
+  unsigned CachedBlock = ~0u;
+  std::vector<Memory> InCache;
+  std::vector<Memory> OutCache;
+
+  /**
+   * @brief Apply the transfer function to every instruction of block B in
+   * order, turning Mem from the In Memory of the block into its Out Memory.
+   * There is no join inside a block, so it is evaluated in one sweep.
+   *
+   * @param Record Also store the memories of every instruction of B in
+   * InCache and OutCache.
+   */
+  void transferBlock(unsigned B, Memory &Mem, bool Record) {
+    for (unsigned N = Graph.blockBegin(B); N != Graph.blockEnd(B); ++N) {
+      Memory Out = Mem;
+      T.transfer(Graph.instruction(N), &Mem, Out);
+      if (Record) {
+        InCache.push_back(std::move(Mem));
+        OutCache.push_back(Out);
+      }
+      Mem = std::move(Out);
+    }
+  }
+
+  void replay(unsigned B) {
+    if (B == CachedBlock)
+      return;
+
+    CachedBlock = B;
+    InCache.clear();
+    OutCache.clear();
+
+    // An unreachable block has empty memories. A head is evaluated from its
+    // widened In, everything else from its predecessors.
+    Memory Mem;
+    bool Reachable = Evaluated[B];
+    if (Reachable && Heads[B])
+      Mem = HeadIn[B];
+    else if (Reachable)
+      Reachable = flowIn(B, Mem);
+    if (!Reachable) {
+      unsigned Size = Graph.blockEnd(B) - Graph.blockBegin(B);
+      InCache.resize(Size);
+      OutCache.resize(Size);
+      return;
+    }
+    transferBlock(B, Mem, true);
+  }
+};
+
+//===----------------------------------------------------------------------===//
+// Iteration Strategies
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Chaotic iteration: pop a block from a worklist, evaluate it from its
+ * predecessors, and push its successors if its Out memory changed.
+ *
+ * Every block starts with an empty Out memory that flows to its successors,
+ * until it is found with every edge into it infeasible, so the lattice needs
+ * no widening and must have finite height. WorklistT
+ * picks the order; the default pops blocks in reverse post-order.
+ */
+template <typename WorklistT = Worklist> struct ChaoticIteration {
+  static constexpr bool FlowsInitialOut = true;
+
+  template <typename Engine> void run(Engine &E) const {
+    WorklistT WorkSet(E.graph());
+    WorkSet.insertAll();
+    while (!WorkSet.empty()) {
+      unsigned B = WorkSet.pop();
+      if (E.update(B)) {
+        for (unsigned Succ : E.graph().blockSuccessors(B))
+          WorkSet.insert(Succ);
+      }
+    }
+  }
+};
+
+/**
+ * @brief Bourdoncle's recursive iteration strategy over a weak topological
+ * order.
+ *
+ * Blocks are evaluated in WTO order. Every edge goes forward in that order
+ * except the back edges to component heads, so a block outside any
+ * component is evaluated once. A component is stabilized, inner components
+ * first, by re-evaluating its body until the In memory of its head stops
+ * changing. The head In is joined for the first rounds, then widened; once
+ * stable, a few narrowing rounds recover bounds lost to widening.
+ *
+ * Blocks not evaluated yet are Bottom, so the Out memories start out not
+ * flowing. Unreachable blocks are never evaluated.
+ */
+class RecursiveIteration {
+ public:
+  static constexpr bool FlowsInitialOut = false;
+
+  /**
+   * @param WTO Iteration order of the blocks.
+   * @param Delays Number of rounds the In of each head, by block number, is
+   * joined before it is widened.
+   * @param NarrowIterations Maximum number of narrowing rounds per component.
+   */
+  RecursiveIteration(const WeakTopologicalOrder &WTO, ArrayRef<unsigned> Delays,
+      unsigned NarrowIterations)
+      : WTO(WTO), Delays(Delays), NarrowIterations(NarrowIterations) {}
+
+  template <typename Engine> void run(Engine &E) const { iterate(E, 0, WTO.size()); }
+
+ private:
+  const WeakTopologicalOrder &WTO;
+  ArrayRef<unsigned> Delays;
+  unsigned NarrowIterations;
+
+  // Stabilize the WTO elements at positions [Begin, End).
+  template <typename Engine> void iterate(Engine &E, unsigned Begin, unsigned End) const {
+    for (unsigned I = Begin; I < End;) {
+      if (WTO.isHead(I)) {
+        stabilize(E, I);
+        I = WTO.componentEnd(I);
+      } else {
+        typename Engine::Memory In;
+        bool Reachable = E.flowIn(WTO.block(I), In);
+        E.evaluate(WTO.block(I), std::move(In), Reachable);
+        ++I;
+      }
+    }
+  }
+
+  // Stabilize the component headed at position I, widening at its head.
+  template <typename Engine> void stabilize(Engine &E, unsigned I) const {
+    using Memory = typename Engine::Memory;
+    unsigned Head = WTO.block(I);
+    unsigned End = WTO.componentEnd(I);
+    Memory &HeadIn = E.headIn(Head);
+    const auto &L = E.lattice();
+
+    // Ascending rounds.
+    for (unsigned Round = 0;; ++Round) {
+      Memory In;
+      bool Reachable = E.flowIn(Head, In);
+
+      if (Round > 0) {
+        Reachable |= E.evaluated(Head);
+        if (Round <= Delays[Head])
+          In = L.join(HeadIn, In);
+        else
+          In = L.widen(HeadIn, In);
+        if (L.equal(In, HeadIn))
+          break;
+      }
+
+      HeadIn = In;
+      E.evaluate(Head, std::move(In), Reachable);
+      iterate(E, I + 1, End);
+    }
+
+    if (!E.evaluated(Head))
+      return;
+
+    // Descending rounds.
+    for (unsigned Round = 0; Round < NarrowIterations; ++Round) {
+      Memory In;
+      E.flowIn(Head, In);
+      In = L.narrow(HeadIn, In);
+      if (L.equal(In, HeadIn))
+        break;
+
+      HeadIn = In;
+      E.evaluate(Head, std::move(In), true);
+      iterate(E, I + 1, End);
+    }
+  }
+};
+
+}  // namespace dataflow
+
+#endif  // DATAFLOW_ENGINE_H
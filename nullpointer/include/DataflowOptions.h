@@ -0,0 +1,124 @@
+#ifndef DATAFLOW_OPTIONS_H
+#define DATAFLOW_OPTIONS_H
+
+#include "llvm/ADT/StringRef.h"
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Pass Options
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Pointer analysis used by the NullPtr pass.
+ */
+enum class PointerMode {
+  // Inclusion-based, the most precise.
+  Andersen,
+  // Unification-based, near-linear time.
+  Steensgaard,
+  // Andersen refined along memory def-use chains, with strong updates.
+  FlowSensitive,
+  // Steensgaard for functions above the size limits, Andersen otherwise.
+  Auto,
+};
+
+/**
+ * @brief Options of the dataflow passes, given as pass parameters in the
+ * pipeline, e.g. -passes='Overflow<stats;widen-delay=3>'.
+ */
+struct DataflowOptions {
+  /**
+   * @brief Print the worklist counters of every function to stderr.
+   */
+  bool Stats = false;
+
+  /**
+   * @brief Print the points-to sets of the pointer analyses NullPtr uses
+   * (print-pointers).
+   */
+  bool PrintPointers = false;
+
+  /**
+   * @brief Number of iterations of a loop that use join before widening
+   * starts (widen-delay=K).
+   */
+  unsigned WidenDelay = 2;
+
+  /**
+   * @brief Maximum number of narrowing iterations of a loop once its
+   * ascending iteration is stable (narrow=N).
+   */
+  unsigned NarrowIterations = 2;
+
+  /**
+   * @brief Pointer analysis of the NullPtr pass
+   * (pointers=andersen|steensgaard|flow-sensitive|auto).
+   */
+  PointerMode Pointers = PointerMode::Auto;
+
+  /**
+   * @brief In auto mode, functions with more instructions than this
+   * (steensgaard-insts=N) or more pointer values (steensgaard-pointers=N) use
+   * Steensgaard.
+   */
+  unsigned SteensgaardInsts = 20000;
+  unsigned SteensgaardPointers = 10000;
+
+  /**
+   * @brief Number of threads solving the Andersen constraints
+   * (pointer-threads=N). With more than one, the constraints are solved by
+   * wave propagation instead of the sequential worklist.
+   */
+  unsigned PointerThreads = 1;
+
+  /**
+   * @brief Number of functions analyzed at once (threads=N). The reports are
+   * printed in the order of the functions in the module whatever N is.
+   */
+  unsigned Threads = 1;
+
+  /**
+   * @brief Analyze the functions bottom-up over the call graph, and apply
+   * the summaries of the callees at their calls (summaries).
+   */
+  bool Summaries = false;
+
+  /**
+   * @brief Number of call contexts for which a function is analyzed again
+   * with the abstract values of the arguments at the call (contexts=N), on
+   * top of its summary for any arguments. Implies Summaries; 0 disables it.
+   */
+  unsigned Contexts = 0;
+
+  /**
+   * @brief Also run the other pointer analysis and report how many checks
+   * change verdict (compare-pointers).
+   */
+  bool ComparePointers = false;
+
+  /**
+   * @brief Time how long the incremental pointer analysis takes to update
+   * and answer a query after an edit, against a rebuild (time-edits).
+   */
+  bool TimeEdits = false;
+};
+
+/**
+ * @brief Name of a pointer analysis, as given to the pointers= option.
+ */
+llvm::StringRef pointerModeName(PointerMode Mode);
+
+/**
+ * @brief Parse a pipeline element of the form Pass or Pass<option;...>.
+ *
+ * @param Name The pipeline element.
+ * @param Pass The name of the pass.
+ * @param Options Set from the options in Name.
+ * @return true if Name names Pass and all of its options are known.
+ */
+bool parsePassName(llvm::StringRef Name, llvm::StringRef Pass, DataflowOptions &Options);
+
+}  // namespace dataflow
+
+#endif  // DATAFLOW_OPTIONS_H
@@ -1,7 +1,13 @@
 #ifndef DIV_ZERO_ANALYSIS_H
 #define DIV_ZERO_ANALYSIS_H
 
+#include "DataflowEngine.h"
+#include "DataflowOptions.h"
 #include "Domain.h"
+#include "FunctionIndex.h"
+#include "FunctionSummary.h"
+#include "ValueIndex.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -14,18 +20,37 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace dataflow {
 
-using Memory = std::map<std::string, Domain *>;
-
 struct DivZeroAnalysis : public llvm::PassInfoMixin<DivZeroAnalysis> {
-  std::map<llvm::Instruction *, Memory *> InMap;
-  std::map<llvm::Instruction *, Memory *> OutMap;
+  using Engine = DataflowEngine<DomainLattice, DivZeroAnalysis>;
+
   llvm::SetVector<llvm::Instruction *> ErrorInsts;
+  // Value and instruction numbering of the function analyzed, owned by this
+  // analysis or by the ProductAnalysis driving it.
+  const ValueIndex *Index = nullptr;
+  const FunctionIndex *Graph = nullptr;
+  // Fixpoint of the function analyzed: the Out memory of every block, from
+  // which the memories of the instructions are rebuilt.
+  std::unique_ptr<Engine> Fixpoint;
+  // Has the fixpoint of the function analyzed evaluated a block? The
+  // returns of the blocks it has not are left out of its summary.
+  std::function<bool(unsigned)> Reached;
+  DataflowOptions Options;
+  // Stream of the memories and statistics printed by analyze().
+  llvm::raw_ostream *Log = &llvm::errs();
+  // Summaries of the callees of the function analyzed, read at its calls,
+  // and of the function itself, filled by analyze(); none if null.
+  SummaryTable *Summaries = nullptr;
+
+  DivZeroAnalysis(DataflowOptions Options = DataflowOptions()) : Options(Options) {}
 
   /**
    * This function is called for each function F in the input C program
@@ -34,53 +59,115 @@ struct DivZeroAnalysis : public llvm::PassInfoMixin<DivZeroAnalysis> {
    */
   llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
 
+  /**
+   * @brief Number F: the part of run() to do before the functions are
+   * analyzed in parallel.
+   */
+  void setup(Function &F, FunctionAnalysisManager &FAM);
+
+  /**
+   * @brief Solve F and check its instructions, after setup().
+   */
+  void analyze(Function &F);
+
+  /**
+   * @brief Print the instructions of F flagged by analyze() to Out.
+   */
+  void report(Function &F, raw_ostream &Out);
+
+  /**
+   * @brief Solve F again, after analyze(), with the arguments of Context
+   * instead of MaybeZero ones, and summarize it for that context.
+   */
+  FunctionSummary analyzeContext(Function &F, const CallContext &Context);
+
  protected:
+  friend Engine;
+  friend struct ProductAnalysis;
+
   /**
    * This function creates a transfer function that updates the Out Memory based
    * on In Memory and the instruction type/parameters.
    */
   void transfer(Instruction *I, const Memory *In, Memory &NOut);
 
+  /**
+   * @brief Set the In Memory of the entry block: arguments are MaybeZero,
+   * or as in the context of analyzeContext().
+   */
+  void entry(Memory &InMem);
+
+  /**
+   * @brief Refine the Out Memory of Pred for its edge to B: a branch on an
+   * integer compared with zero makes it Zero or NonZero along each edge.
+   *
+   * @return false if the edge is infeasible.
+   */
+  bool edge(unsigned Pred, unsigned B, Memory &Mem);
+
   /**
    * @brief This function implements the chaotic iteration algorithm using
-   * flowIn(), transfer(), and flowOut().
+   * entry(), edge() and transfer().
    *
    * @param F The function to be analyzed.
    */
   void doAnalysis(Function &F);
 
   /**
-   * @brief Flow the abstract domains from all predecessors of Inst into the In
-   * Memory object for Inst.
+   * Can the Instruction Inst incurr a divide by zero error?
    *
-   * @param Inst Instruction to flow In Memory for.
-   * @param InMem InMemory object of Inst to populate.
+   * @param Inst Instruction to check.
+   * @param InState Returns the In memory of an instruction at the fixpoint,
+   * by number.
+   * @return true if the instruction can incur a divide by zero error.
    */
-  void flowIn(Instruction *Inst, Memory *InMem);
+  bool check(Instruction *Inst, function_ref<const Memory &(unsigned)> InState);
 
   /**
-   * @brief Merge the previous Out Memory of Inst with the current Out Memory
-   * for each instruction to update the OutMap and WorkSet as needed.
+   * @brief Summarize F for its callers: whether the integers it returns can
+   * be zero.
    *
-   * @param Inst Instruction to flow Out Memory for.
-   * @param Pre Previous OutMemory of Inst.
-   * @param Post Current OutMemory of Inst.
-   * @param WorkSet WorkSet
+   * @param F The function analyzed.
+   * @param InState Returns the In memory of an instruction at the fixpoint,
+   * by number.
+   * @param Summary The summary of F, set by this function.
    */
-  void flowOut(
-      Instruction *Inst, Memory *Pre, Memory *Post, SetVector<Instruction *> &WorkSet);
+  void summarize(Function &F, function_ref<const Memory &(unsigned)> InState,
+      FunctionSummary &Summary);
 
   /**
-   * Can the Instruction Inst incurr a divide by zero error?
+   * @brief Get the summary of the callee of Call, for the zero-ness of its
+   * arguments in In if call contexts are enabled.
    *
-   * @param Inst Instruction to check.
-   * @return true if the instruction can incur a divide by zero error.
+   * @return const FunctionSummary* The summary, or null if there is none.
+   */
+  const FunctionSummary *callSummary(CallInst *Call, const Memory *In);
+
+  /**
+   * @brief Add the zero-ness of the arguments of Call in In to Context.
    */
-  bool check(Instruction *Inst);
+  void addArguments(CallInst *Call, const Memory *In, CallContext &Context);
+
+  /**
+   * @brief Set the integer returned by Call in NOut from the summary of its
+   * callee.
+   */
+  void applySummary(CallInst *Call, const FunctionSummary &Summary, const Memory *In,
+      Memory &NOut);
 
   std::string getAnalysisName() {
     return "DivZero";
   }
+
+ private:
+  // Numbering built by setup(), unless a ProductAnalysis shares its own.
+  std::unique_ptr<ValueIndex> Values;
+  std::unique_ptr<FunctionIndex> Blocks;
+  // Arguments of the context solved by analyzeContext(), or null while the
+  // arguments can be any value.
+  const CallContext *EntryContext = nullptr;
+  // Contexts admitted at the calls of the current solve.
+  ContextSlots Slots;
 };
 }  // namespace dataflow
 
@@ -1,6 +1,7 @@
 #ifndef DOMAIN_H
 #define DOMAIN_H
 
+#include "PersistentMap.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -13,6 +14,8 @@ namespace dataflow {
 
 /*
  * Implement your abstract domain.
+ *
+ * A Domain is a single enum value, so it is passed and stored by value.
  */
 class Domain {
  public:
@@ -36,24 +39,43 @@ class Domain {
   Element Value;
 
   // Arithmetic operations for divide-by-zero analysis
-  static Domain *add(Domain *E1, Domain *E2);
-  static Domain *sub(Domain *E1, Domain *E2);
-  static Domain *mul(Domain *E1, Domain *E2);
-  static Domain *div(Domain *E1, Domain *E2);
+  static Domain add(Domain E1, Domain E2);
+  static Domain sub(Domain E1, Domain E2);
+  static Domain mul(Domain E1, Domain E2);
+  static Domain div(Domain E1, Domain E2);
 
   // Arithmetic operations for overflow analysis
-  static Domain *addOverflow(Domain *E1, Domain *E2);
-  static Domain *subOverflow(Domain *E1, Domain *E2);
-  static Domain *mulOverflow(Domain *E1, Domain *E2);
-  static Domain *shlOverflow(Domain *E1, Domain *E2);
+  static Domain addOverflow(Domain E1, Domain E2);
+  static Domain subOverflow(Domain E1, Domain E2);
+  static Domain mulOverflow(Domain E1, Domain E2);
+  static Domain shlOverflow(Domain E1, Domain E2);
 
-  static Domain *join(Domain *E1, Domain *E2);
+  static Domain join(Domain E1, Domain E2);
   static bool equal(Domain E1, Domain E2);
-  void print(raw_ostream &O);
+  void print(raw_ostream &O) const;
 };
 
 raw_ostream &operator<<(raw_ostream &O, Domain V);
 
+using Memory = PersistentMap<Domain>;
+
+/**
+ * @brief Lattice of the memories of Domain elements, for DataflowEngine.
+ *
+ * A variable missing from a memory is Uninit. The lattice has finite height,
+ * so it is solved by chaotic iteration without widening.
+ */
+struct DomainLattice {
+  using Memory = dataflow::Memory;
+
+  Memory join(const Memory &A, const Memory &B) const { return Memory::join(A, B); }
+
+  bool equal(const Memory &A, const Memory &B) const {
+    const Domain Uninit(Domain::Uninit);
+    return Memory::equal(A, B, &Uninit);
+  }
+};
+
 }  // namespace dataflow
 
 #endif  // DOMAIN_H
@@ -4,6 +4,8 @@
 
 #include "llvm/Support/raw_ostream.h"
 
+#include <vector>
+
 namespace overflow {
 
 class DomainOverflow {
@@ -38,6 +40,15 @@ public:
                              const DomainOverflow &B);
   static DomainOverflow widen(const DomainOverflow &Old,
                               const DomainOverflow &New);
+  // Like widen, but a growing bound moves to the next value of the sorted
+  // Thresholds before it goes to infinity
+  static DomainOverflow widenWithThresholds(
+      const DomainOverflow &Old, const DomainOverflow &New,
+      const std::vector<long long> &Thresholds);
+  static DomainOverflow narrow(const DomainOverflow &Old,
+                               const DomainOverflow &New);
+  static DomainOverflow meet(const DomainOverflow &A,
+                             const DomainOverflow &B);
   static bool equal(const DomainOverflow &A,
                     const DomainOverflow &B);
 
@@ -0,0 +1,107 @@
+#ifndef FLOW_SENSITIVE_ANALYSIS_H
+#define FLOW_SENSITIVE_ANALYSIS_H
+
+#include "PointerAnalysis.h"
+#include "llvm/ADT/DenseMap.h"
+
+#include <utility>
+#include <vector>
+
+namespace dataflow {
+
+/**
+ * @brief Sparse flow-sensitive pointer analysis, staged on Andersen.
+ *
+ * The flow-insensitive result tells which sites each load may read and each
+ * store may write. From it, the contents of every site are put in SSA form
+ * (memory SSA): each store defines a new version of the sites it may write,
+ * versions meet at phis on the iterated dominance frontier, and each load
+ * reads the versions that reach it. Points-to sets are then propagated only
+ * along these def-use chains, never through the rest of the function.
+ *
+ * A store through a pointer that points to a single static or non-escaping
+ * alloca replaces the contents of the site (strong update), so the loads
+ * after it see the stored pointer only. Every pointer is an SSA value, so
+ * its points-to set holds wherever it is used, and the alias rows stay per
+ * pointer.
+ */
+class FlowSensitiveAnalysis : public PointerAnalysis {
+ public:
+  /**
+   * @brief Build the memory SSA of F from a flow-insensitive result and
+   * propagate the points-to sets along it.
+   *
+   * @param F The function for which pointer analysis is done
+   * @param Index Value numbering of F
+   * @param Insensitive Solved Andersen analysis of F
+   */
+  FlowSensitiveAnalysis(Function &F, const ValueIndex &Index, const PointerAnalysis &Insensitive);
+
+ protected:
+  SetRef pointsToNode(unsigned N) const override { return Pts[N]; }
+
+  SetRef contents(unsigned Site) const override { return Contents[Site]; }
+
+ private:
+  /**
+   * @brief A version of the contents of one site: the initial, empty one, a
+   * store that may write the site, or a phi.
+   */
+  struct MemoryDef {
+    unsigned Site;
+    // Pointer and value nodes of a store, NoNode for a phi.
+    unsigned Ptr;
+    unsigned Val;
+    // Version overwritten by a store, or the incoming versions of a phi.
+    std::vector<unsigned> Prev;
+  };
+
+  /**
+   * @brief A load of a pointer: its node, the node of its pointer operand
+   * and the version of every site it may read.
+   */
+  struct MemoryUse {
+    unsigned Ptr;
+    std::vector<std::pair<unsigned, unsigned>> Reads;
+  };
+
+  // Pointer nodes followed by one node per version.
+  std::vector<SetRef> Pts;
+  std::vector<MemoryDef> Defs;
+  DenseMap<unsigned, MemoryUse> Uses;
+  // Nodes whose set is computed from the set of each node.
+  std::vector<std::vector<unsigned>> Users;
+  // Position of each node in reverse post-order, the worklist priority.
+  std::vector<unsigned> Rank;
+  // Sites whose contents can be overwritten by a strong update.
+  BitVector Singular;
+  // Union of the versions of every site.
+  std::vector<SetRef> Contents;
+
+  static const unsigned Initial = 0;
+
+  unsigned versionNode(unsigned Def) const { return NumNodes + Def; }
+
+  /**
+   * @brief Place the phis, number the versions in dominator-tree order and
+   * link every load and store to the versions it reads.
+   *
+   * @param Accessed Sites read or written by each load and store, from the
+   * flow-insensitive result
+   */
+  void buildMemorySSA(Function &F, const DenseMap<const Instruction *, SetRef> &Accessed);
+
+  /**
+   * @brief Recompute the set of node N from the nodes it depends on.
+   */
+  SetRef evaluate(unsigned N);
+
+  /**
+   * @brief Propagate the sets in reverse post-order until none grows.
+   */
+  void solve();
+};
+
+}  // namespace dataflow
+
+#endif  // FLOW_SENSITIVE_ANALYSIS_H
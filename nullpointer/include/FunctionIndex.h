@@ -0,0 +1,158 @@
+#ifndef FUNCTION_INDEX_H
+#define FUNCTION_INDEX_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+
+#include <vector>
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Instruction-level Control-Flow Graph
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief FunctionIndex numbers the instructions of a function in layout order
+ * and stores the instruction-level control-flow graph in compressed sparse row
+ * form.
+ *
+ * The predecessor of an instruction is the previous instruction of its block,
+ * or, for the first instruction of a block, the terminators of the predecessor
+ * blocks. Successors are defined symmetrically.
+ *
+ * Basic blocks are numbered in layout order as well, so the instructions of a
+ * block form the contiguous range [blockBegin(B), blockEnd(B)). The block-level
+ * graph is stored in the same form; the dataflow engines iterate over it and
+ * keep one In and Out memory per block.
+ *
+ * Every block also has a reverse post-order index, which the worklists use as
+ * priority. Blocks unreachable from the entry come after all reachable ones.
+ */
+class FunctionIndex {
+ public:
+  /**
+   * @brief Number the instructions of F and build the CSR tables.
+   *
+   * @param F The function to index.
+   */
+  FunctionIndex(Function &F);
+
+  /**
+   * @brief Number of instructions in the function.
+   */
+  unsigned size() const { return Insts.size(); }
+
+  /**
+   * @brief Get the layout number of Inst.
+   *
+   * @param Inst An instruction of the function.
+   * @return unsigned The number of Inst.
+   */
+  unsigned number(const Instruction *Inst) const;
+
+  /**
+   * @brief Get the instruction numbered N.
+   */
+  Instruction *instruction(unsigned N) const { return Insts[N]; }
+
+  /**
+   * @brief Get the numbers of the predecessors of instruction N.
+   */
+  ArrayRef<unsigned> predecessors(unsigned N) const {
+    return makeArrayRef(Preds.data() + PredBegin[N], Preds.data() + PredBegin[N + 1]);
+  }
+
+  /**
+   * @brief Get the numbers of the successors of instruction N.
+   */
+  ArrayRef<unsigned> successors(unsigned N) const {
+    return makeArrayRef(Succs.data() + SuccBegin[N], Succs.data() + SuccBegin[N + 1]);
+  }
+
+  /**
+   * @brief Number of basic blocks in the function.
+   */
+  unsigned blocks() const { return Blocks.size(); }
+
+  /**
+   * @brief Get the basic block numbered B.
+   */
+  BasicBlock *basicBlock(unsigned B) const { return Blocks[B]; }
+
+  /**
+   * @brief Get the number of the block containing instruction N.
+   */
+  unsigned block(unsigned N) const { return BlockOf[N]; }
+
+  /**
+   * @brief Get the number of Block, which must belong to the function.
+   */
+  unsigned blockNumber(const BasicBlock *Block) const {
+    return block(number(&Block->front()));
+  }
+
+  /**
+   * @brief Get the number of the first instruction of block B.
+   */
+  unsigned blockBegin(unsigned B) const { return InstBegin[B]; }
+
+  /**
+   * @brief Get one past the number of the terminator of block B.
+   */
+  unsigned blockEnd(unsigned B) const { return InstBegin[B + 1]; }
+
+  /**
+   * @brief Get the reverse post-order index of block B.
+   */
+  unsigned rpoIndex(unsigned B) const { return RPOIndex[B]; }
+
+  /**
+   * @brief Get the block at reverse post-order index I.
+   */
+  unsigned rpoBlock(unsigned I) const { return RPOBlocks[I]; }
+
+  /**
+   * @brief Get the numbers of the predecessor blocks of block B.
+   */
+  ArrayRef<unsigned> blockPredecessors(unsigned B) const {
+    return makeArrayRef(BlockPreds.data() + BlockPredBegin[B],
+        BlockPreds.data() + BlockPredBegin[B + 1]);
+  }
+
+  /**
+   * @brief Get the numbers of the successor blocks of block B.
+   */
+  ArrayRef<unsigned> blockSuccessors(unsigned B) const {
+    return makeArrayRef(BlockSuccs.data() + BlockSuccBegin[B],
+        BlockSuccs.data() + BlockSuccBegin[B + 1]);
+  }
+
+ private:
+  std::vector<Instruction *> Insts;
+  DenseMap<const Instruction *, unsigned> Numbers;
+
+  // Row offsets (size() + 1 entries) and column entries of the CSR tables.
+  std::vector<unsigned> PredBegin;
+  std::vector<unsigned> Preds;
+  std::vector<unsigned> SuccBegin;
+  std::vector<unsigned> Succs;
+
+  std::vector<BasicBlock *> Blocks;
+  std::vector<unsigned> BlockOf;
+  // First instruction of each block (blocks() + 1 entries).
+  std::vector<unsigned> InstBegin;
+  std::vector<unsigned> BlockPredBegin;
+  std::vector<unsigned> BlockPreds;
+  std::vector<unsigned> BlockSuccBegin;
+  std::vector<unsigned> BlockSuccs;
+  std::vector<unsigned> RPOIndex;
+  std::vector<unsigned> RPOBlocks;
+};
+
+}  // namespace dataflow
+
+#endif  // FUNCTION_INDEX_H
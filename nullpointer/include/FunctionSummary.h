@@ -0,0 +1,192 @@
+#ifndef FUNCTION_SUMMARY_H
+#define FUNCTION_SUMMARY_H
+
+#include "Domain.h"
+#include "DomainOverflow.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstrTypes.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Interprocedural Summaries
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief What the callers of a function need to know about it, computed
+ * once from its fixpoint and applied at every call in constant time.
+ *
+ * The summary of a function does not depend on its callers: it is computed
+ * with the arguments unknown, as the intraprocedural analyses assume them.
+ */
+struct FunctionSummary {
+  /**
+   * @brief Nullness of the returned pointer, Uninit if none is returned.
+   */
+  Domain Null = Domain(Domain::Uninit);
+
+  /**
+   * @brief The pointer arguments that the function, or a function it calls,
+   * dereferences without testing them for null, by position.
+   */
+  std::vector<bool> Dereferenced;
+
+  /**
+   * @brief Zero-ness of the returned integer, Uninit if none is returned.
+   */
+  Domain Zero = Domain(Domain::Uninit);
+
+  /**
+   * @brief Interval of the returned integer, bottom if none is returned.
+   */
+  overflow::DomainOverflow Range;
+
+  /**
+   * @brief If not -1, every returned integer is argument RangeArg plus an
+   * offset in RangeOffset, so a call returns the interval of its argument
+   * shifted by RangeOffset, met with Range.
+   */
+  int RangeArg = -1;
+  overflow::DomainOverflow RangeOffset;
+};
+
+/**
+ * @brief The abstract values of the arguments of a call, for the analyses
+ * that give them; an analysis that does not leaves its vector empty, and
+ * the callee takes any value for them.
+ */
+struct CallContext {
+  std::vector<Domain> Null;
+  std::vector<Domain> Zero;
+  std::vector<overflow::DomainOverflow> Ranges;
+
+  /**
+   * @brief Encode the context as a key of the memo table of the callee.
+   */
+  std::vector<long long> key() const;
+};
+
+/**
+ * @brief The contexts met at each call by one solve of a function, by key,
+ * and whether each got a summary of its own.
+ *
+ * Every solve has its own slots, so the contexts a call admits are the
+ * first ones of that solve, whatever the order in which the callers of the
+ * callee run.
+ */
+using ContextSlots = DenseMap<const CallBase *, std::map<std::vector<long long>, bool>>;
+
+/**
+ * @brief The summaries of the functions defined in a module, and the order
+ * in which they can be computed.
+ *
+ * The functions are grouped by strongly connected component of the call
+ * graph, and the components in levels: the callees of a component that are
+ * out of it are in lower levels, so the components of one level can be
+ * analyzed at the same time, once the levels below are done. A call to a
+ * function of the same component, as in recursion, has no summary and is
+ * analyzed as an unknown call.
+ *
+ * All entries are created by the constructor, so the summary of a function
+ * can be written while those of the other functions are read.
+ *
+ * A function can also be summarized per call context: lookup() with a
+ * context analyzes the callee for it the first time, with the analyzer set
+ * for the callee, and memoizes the summary. Each call admits up to
+ * MaxContexts contexts in each solve of its caller. The contexts of one
+ * function are analyzed one at a time.
+ */
+class SummaryTable {
+ public:
+  /**
+   * @brief Order the functions defined in the module of the call graph CG
+   * by its components, bottom-up.
+   */
+  SummaryTable(CallGraph &CG, unsigned MaxContexts = 0);
+
+  /**
+   * @brief Get the summary of the function called by Call.
+   *
+   * @return const FunctionSummary* The summary, or null if the call is
+   * indirect, or its callee is not defined in the module or is in the
+   * component of the caller.
+   */
+  const FunctionSummary *lookup(const CallBase &Call) const;
+
+  /**
+   * @brief Get the summary of the function called by Call for the abstract
+   * arguments of Context.
+   *
+   * @param Slots The contexts admitted so far by the solve of the caller.
+   * @return const FunctionSummary* The summary of the callee memoized for
+   * Context, analyzed now if it is new, if Call admits it; else the summary
+   * of the callee for any arguments, or null as lookup(Call).
+   */
+  const FunctionSummary *lookup(
+      const CallBase &Call, const CallContext &Context, ContextSlots &Slots) const;
+
+  /**
+   * @brief Set the function that analyzes F for a call context, once the
+   * summary of F is filled.
+   */
+  void setAnalyzer(const Function &F,
+      std::function<FunctionSummary(const CallContext &)> Analyzer);
+
+  /**
+   * @brief Print how many contexts of F were analyzed, and how many times a
+   * solve of a caller admitted a context at a call of F that was already
+   * analyzed, or met one over the limit.
+   */
+  void printContexts(raw_ostream &OS, const Function &F) const;
+
+  /**
+   * @brief Get the summary of F, defined in the module, to fill it.
+   */
+  FunctionSummary &summary(const Function &F);
+
+  /**
+   * @brief The defined functions of the module, level by level from the
+   * leaves of the call graph.
+   */
+  const std::vector<std::vector<Function *>> &levels() const { return Levels; }
+
+ private:
+  /**
+   * @brief Memo table of the context summaries of one function.
+   */
+  struct ContextTable {
+    std::mutex Lock;
+    std::function<FunctionSummary(const CallContext &)> Analyzer;
+    std::map<std::vector<long long>, FunctionSummary> Summaries;
+    // Distinct (solve, call, context) admitted and refused: which solve
+    // analyzes a context depends on the threads, but these do not.
+    unsigned Admitted = 0;
+    unsigned OverLimit = 0;
+  };
+
+  struct Entry {
+    unsigned Component;
+    unsigned Level;
+    FunctionSummary Summary;
+    std::unique_ptr<ContextTable> Contexts;
+  };
+
+  unsigned MaxContexts;
+  DenseMap<const Function *, Entry> Entries;
+  std::vector<std::vector<Function *>> Levels;
+};
+
+}  // namespace dataflow
+
+#endif  // FUNCTION_SUMMARY_H
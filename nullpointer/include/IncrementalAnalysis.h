@@ -0,0 +1,181 @@
+#ifndef INCREMENTAL_ANALYSIS_H
+#define INCREMENTAL_ANALYSIS_H
+
+#include "PointerAnalysis.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+
+#include <deque>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace dataflow {
+
+/**
+ * @brief Andersen pointer analysis kept up to date while the function is
+ * edited.
+ *
+ * A client that inserts or erases an instruction tells the analysis with
+ * insert() or erase(), and the alias queries that follow see the edit. An
+ * insertion adds the constraint of the instruction, and the sites it adds are
+ * propagated like in the Andersen worklist. An erasure removes the
+ * constraint; the sites that may have been derived through it are taken
+ * out of the sets and derived again from the rest of the graph, and all other
+ * sites are left where they are. Only the rows of the pointers whose sets
+ * changed are updated.
+ *
+ * To make copy edges removable, each edge counts the load and store
+ * constraints that add it, and the nodes of a cycle are kept apart, sharing
+ * their set instead of being merged.
+ */
+class IncrementalAnalysis : public PointerAnalysis {
+ public:
+  /**
+   * @brief Collect the constraints of F and solve them.
+   *
+   * @param F The function for which pointer analysis is done
+   * @param Index Value numbering of F, which numbers the inserted values
+   */
+  IncrementalAnalysis(Function &F, ValueIndex &Index);
+
+  /**
+   * @brief Add the constraint of I, just inserted into the function.
+   *
+   * An instruction whose operands change is erased and inserted again.
+   */
+  void insert(Instruction *I);
+
+  /**
+   * @brief Remove the constraint of I, about to be erased from the function.
+   */
+  void erase(Instruction *I);
+
+ protected:
+  SetRef pointsToNode(unsigned N) const override { return Graph[PointerNode[N]].Pts; }
+
+  SetRef contents(unsigned Site) const override { return Graph[SiteNode[Site]].Pts; }
+
+ private:
+  /**
+   * @brief A node of the constraint graph: a pointer node or the contents of
+   * a site.
+   */
+  struct Node {
+    // Pointer node, or NoNode for the contents of a site.
+    unsigned Ptr;
+    // Site of an alloca node, the part of Pts owed to no other node.
+    SetRef Base;
+    SetRef Pts;
+    // The part of Pts whose load and store edges were added.
+    SetRef Resolved;
+    std::vector<unsigned> Succs;
+    std::vector<unsigned> Preds;
+    // Nodes L loaded through this one: L = *this.
+    std::vector<unsigned> Loads;
+    // Nodes R stored through this one: *this = R.
+    std::vector<unsigned> Stores;
+  };
+
+  using Key = std::tuple<unsigned, unsigned, unsigned>;
+
+  // Sites a node may lose.
+  using Loss = std::pair<unsigned, SetRef>;
+
+  ValueIndex &Values;
+
+  std::vector<Node> Graph;
+  std::vector<unsigned> PointerNode;
+  std::vector<unsigned> SiteNode;
+
+  /**
+   * @brief Constraint of each instruction, and the number of instructions
+   * with each distinct constraint.
+   */
+  DenseMap<const Instruction *, Constraint> Owned;
+  DenseMap<Key, unsigned> Count;
+
+  /**
+   * @brief Number of pairs of a load or store constraint and a site of its
+   * pointer that add each copy edge.
+   */
+  DenseMap<std::pair<unsigned, unsigned>, unsigned> Support;
+
+  std::deque<unsigned> Pending;
+  BitVector Queued;
+
+  /**
+   * @brief Pointer nodes whose set changed since the rows were updated.
+   */
+  SetVector<unsigned> Changed;
+
+  static Key key(const Constraint &C) { return Key(C.Kind, C.Dst, C.Src); }
+
+  unsigned addNode(unsigned Ptr);
+
+  /**
+   * @brief Give the variables and pointer nodes numbered since the last call
+   * their entries.
+   */
+  void grow();
+
+  void push(unsigned N);
+
+  /**
+   * @brief Add the sites of Pts to the set of node N.
+   *
+   * @return true if the set of N grew.
+   */
+  bool flowInto(unsigned N, SetRef Pts);
+
+  /**
+   * @brief Add one support to the edge From -> To, adding the edge if it is
+   * new, or remove one, removing the edge with its last support.
+   */
+  void link(unsigned From, unsigned To);
+  void unlink(unsigned From, unsigned To);
+
+  /**
+   * @brief Add or remove the edges of the load and store constraints of
+   * node N for the sites in Sites.
+   */
+  void resolve(unsigned N, SetRef Sites, bool Add);
+
+  /**
+   * @brief Add or remove the constraint C.
+   *
+   * @param Seeds Receives the sites that nodes may lose when C is removed
+   */
+  void apply(const Constraint &C, bool Add, std::vector<Loss> &Seeds);
+
+  /**
+   * @brief Propagate points-to sets from the pending nodes until no
+   * constraint adds a site.
+   *
+   * Each round finds the cycles of copy edges reachable from the pending
+   * nodes and propagates the sets along the components in topological
+   * order, then adds the edges of the load and store constraints for the new
+   * sites. Cycles are found again each round instead of being collapsed.
+   */
+  void solve();
+
+  /**
+   * @brief Take out of every set the sites that may derive from the ones in
+   * Seeds, then derive again those that still follow from the rest.
+   */
+  void rederive(const std::vector<Loss> &Seeds);
+
+  /**
+   * @brief Drop every copy edge and solve the constraints again.
+   */
+  void restart();
+
+  /**
+   * @brief Recompute whether the allocas among the operands of I escape.
+   */
+  void updateEscapes(Instruction *I, const Instruction *Erased);
+};
+
+}  // namespace dataflow
+
+#endif  // INCREMENTAL_ANALYSIS_H
@@ -1,8 +1,14 @@
 #ifndef NULL_POINTER_ANALYSIS_H
 #define NULL_POINTER_ANALYSIS_H
 
+#include "DataflowEngine.h"
+#include "DataflowOptions.h"
 #include "Domain.h"
+#include "FunctionIndex.h"
+#include "FunctionSummary.h"
 #include "PointerAnalysis.h"
+#include "ValueIndex.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -15,18 +21,40 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace dataflow {
 
-using Memory = std::map<std::string, Domain *>;
-
 struct NullPointerAnalysis : public llvm::PassInfoMixin<NullPointerAnalysis> {
-  std::map<llvm::Instruction *, Memory *> InMap;
-  std::map<llvm::Instruction *, Memory *> OutMap;
+  using Engine = DataflowEngine<DomainLattice, NullPointerAnalysis>;
+
   llvm::SetVector<llvm::Instruction *> ErrorInsts;
+  // Value numbering of the function analyzed, owned by its shared
+  // PointerAnalysisResult.
+  const ValueIndex *Index = nullptr;
+  // Instruction numbering of the function analyzed, owned by this analysis
+  // or by the ProductAnalysis driving it.
+  const FunctionIndex *Graph = nullptr;
+  // Fixpoint of the function analyzed: the Out memory of every block, from
+  // which the memories of the instructions are rebuilt.
+  std::unique_ptr<Engine> Fixpoint;
+  // Has the fixpoint of the function analyzed evaluated a block? The
+  // returns of the blocks it has not are left out of its summary.
+  std::function<bool(unsigned)> Reached;
+  DataflowOptions Options;
+  // Stream of the memories, points-to sets and statistics printed by
+  // analyze().
+  llvm::raw_ostream *Log = &llvm::errs();
+  // Summaries of the callees of the function analyzed, read at its calls,
+  // and of the function itself, filled by analyze(); none if null.
+  SummaryTable *Summaries = nullptr;
+
+  NullPointerAnalysis(DataflowOptions Options = DataflowOptions()) : Options(Options) {}
 
   /**
    * This function is called for each function F in the input C program
@@ -35,57 +63,149 @@ struct NullPointerAnalysis : public llvm::PassInfoMixin<NullPointerAnalysis> {
    */
   llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &);
 
+  /**
+   * @brief Number F and get its pointer analyses from FAM: the part of run()
+   * that uses the analysis manager.
+   */
+  void setup(Function &F, FunctionAnalysisManager &FAM);
+
+  /**
+   * @brief Solve F and check its instructions, after setup().
+   */
+  void analyze(Function &F);
+
+  /**
+   * @brief Print the instructions of F flagged by analyze() to Out.
+   */
+  void report(Function &F, raw_ostream &Out);
+
+  /**
+   * @brief Solve F again, after analyze(), with the arguments of Context
+   * instead of MaybeNull ones, and summarize it for that context.
+   */
+  FunctionSummary analyzeContext(Function &F, const CallContext &Context);
+
  protected:
+  friend Engine;
+  friend struct ProductAnalysis;
+
   /**
    * This function creates a transfer function that updates the Out Memory based
    * on In Memory and the instruction type/parameters.
    */
-  void transfer(Instruction *I,
-      const Memory *In,
-      Memory &NOut,
-      PointerAnalysis *PA,
-      SetVector<Value *> PointerSet);
+  void transfer(Instruction *I, const Memory *In, Memory &NOut);
 
   /**
-   * @brief This function implements the chaotic iteration algorithm using
-   * flowIn(), transfer(), and flowOut().
-   *
-   * @param F The function to be analyzed.
+   * @brief Set the In Memory of the entry block: arguments are MaybeNull,
+   * or as in the context of analyzeContext().
    */
-  void doAnalysis(Function &F, PointerAnalysis *PA);
+  void entry(Memory &InMem);
 
   /**
-   * @brief Flow the abstract domains from all predecessors of Inst into the In
-   * Memory object for Inst.
+   * @brief Refine the Out Memory of block Pred with the null test of its
+   * branch to block B.
    *
-   * @param Inst Instruction to flow In Memory for.
-   * @param InMem InMemory object of Inst to populate.
+   * @return false if the branch cannot be taken.
    */
-  bool flowIn(Instruction *Inst, Memory *InMem);
+  bool edge(unsigned Pred, unsigned B, Memory &Mem);
 
   /**
-   * @brief Merge the previous Out Memory of Inst with the current Out Memory
-   * for each instruction to update the OutMap and WorkSet as needed.
+   * @brief This function implements the chaotic iteration algorithm using
+   * entry(), edge() and transfer().
    *
-   * @param Inst Instruction to flow Out Memory for.
-   * @param Pre Previous OutMemory of Inst.
-   * @param Post Current OutMemory of Inst.
-   * @param WorkSet WorkSet
+   * @param F The function to be analyzed.
+   * @param PA The pointer analysis answering the alias queries of transfer().
    */
-  void flowOut(
-      Instruction *Inst, Memory *Pre, Memory *Post, SetVector<Instruction *> &WorkSet);
+  void doAnalysis(Function &F, const PointerAnalysis *PA);
 
   /**
    * Can the Instruction Inst incurr a null pointer dereference error?
    *
    * @param Inst Instruction to check.
+   * @param InState Returns the In memory of an instruction at the fixpoint,
+   * by number.
    * @return true if the instruction can incur a null pointer dereference error.
    */
-  bool check(Instruction *Inst);
+  bool check(Instruction *Inst, function_ref<const Memory &(unsigned)> InState);
+
+  /**
+   * @brief Summarize F for its callers: the nullness of the pointers it
+   * returns and the arguments it dereferences unchecked.
+   *
+   * @param F The function analyzed.
+   * @param InState Returns the In memory of an instruction at the fixpoint,
+   * by number.
+   * @param Flagged The instructions of F flagged by check().
+   * @param Summary The summary of F, set by this function.
+   */
+  void summarize(Function &F, function_ref<const Memory &(unsigned)> InState,
+      const SetVector<Instruction *> &Flagged, FunctionSummary &Summary);
+
+  /**
+   * @brief Get the summary of the callee of Call, for the nullness of its
+   * arguments in In if call contexts are enabled.
+   *
+   * @return const FunctionSummary* The summary, or null if there is none.
+   */
+  const FunctionSummary *callSummary(CallInst *Call, const Memory *In);
+
+  /**
+   * @brief Add the nullness of the arguments of Call in In to Context.
+   */
+  void addArguments(CallInst *Call, const Memory *In, CallContext &Context);
+
+  /**
+   * @brief Set the pointer returned by Call in NOut from the summary of its
+   * callee.
+   */
+  void applySummary(CallInst *Call, const FunctionSummary &Summary, const Memory *In,
+      Memory &NOut);
+
+  /**
+   * @brief Choose the pointer analysis for F: the one of the options, or in
+   * auto mode Steensgaard when F exceeds the instruction or pointer limit.
+   */
+  PointerMode pointerMode(Function &F);
+
+  /**
+   * @brief Analyze F again with the pointer analysis Other and count the
+   * instructions whose check() verdict differs from Flagged.
+   *
+   * @param F The function analyzed.
+   * @param Other The pointer analysis to compare with.
+   * @param Flagged Verdict of every instruction of F, in layout order.
+   * @return unsigned Number of verdicts that changed.
+   */
+  unsigned countChangedVerdicts(Function &F, PointerMode Other, const std::vector<bool> &Flagged);
+
+  /**
+   * @brief Erase every store of a pointer from an incremental pointer
+   * analysis of F and insert it again, querying the aliases of its pointer
+   * after each edit, and print the mean time of an edit against the time of
+   * rebuilding the analysis.
+   *
+   * The IR is left unchanged, and the final result is checked against the
+   * rebuilt one.
+   */
+  void timeEdits(Function &F);
 
   std::string getAnalysisName() {
     return "NullPtr";
   }
+
+ private:
+  // The pointer analyses of the function analyzed, shared with the other
+  // passes, and the one answering the alias queries of transfer().
+  PointerAnalysisResult *Shared = nullptr;
+  const PointerAnalysis *Pointers = nullptr;
+  // Instruction numbering built by setup(), unless a ProductAnalysis
+  // shares its own.
+  std::unique_ptr<FunctionIndex> Blocks;
+  // Arguments of the context solved by analyzeContext(), or null while the
+  // arguments can be any value.
+  const CallContext *EntryContext = nullptr;
+  // Contexts admitted at the calls of the current solve.
+  ContextSlots Slots;
 };
 }  // namespace dataflow
 
@@ -1,8 +1,17 @@
 #ifndef OVERFLOW_ANALYSIS_H
 #define OVERFLOW_ANALYSIS_H
 
+#include "DataflowEngine.h"
+#include "DataflowOptions.h"
 #include "DomainOverflow.h"
-
+#include "FunctionIndex.h"
+#include "FunctionSummary.h"
+#include "PersistentMap.h"
+#include "ValueIndex.h"
+#include "WeakTopologicalOrder.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 #include "llvm/ADT/SetVector.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/Function.h"
@@ -15,48 +24,172 @@
 #include "llvm/Support/raw_ostream.h"
 
 #include <algorithm>
+#include <functional>
 #include <iterator>
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace dataflow {
 
-// Interval analysis memory: map variable name -> interval (DomainOverflow)
-using OverflowMemory = std::map<std::string, overflow::DomainOverflow>;
+// Interval analysis memory: map variable ID -> interval (DomainOverflow)
+using OverflowMemory = PersistentMap<overflow::DomainOverflow>;
+
+// Lattice of interval memories, for DataflowEngine. Widening steps through
+// the thresholds of the function before it goes to infinity.
+struct OverflowLattice {
+  using Memory = OverflowMemory;
+
+  const std::vector<long long> *Thresholds;
+
+  Memory join(const Memory &A, const Memory &B) const {
+    return Memory::join(A, B);
+  }
+
+  Memory widen(const Memory &Old, const Memory &New) const {
+    return Memory::merge(Old, New,
+        [this](const overflow::DomainOverflow &O,
+               const overflow::DomainOverflow &N) {
+          return overflow::DomainOverflow::widenWithThresholds(O, N,
+                                                               *Thresholds);
+        });
+  }
+
+  Memory narrow(const Memory &Old, const Memory &New) const {
+    return Memory::merge(Old, New,
+        [](const overflow::DomainOverflow &O,
+           const overflow::DomainOverflow &N) {
+          return overflow::DomainOverflow::narrow(O, N);
+        });
+  }
+
+  bool equal(const Memory &A, const Memory &B) const {
+    return Memory::equal(A, B);
+  }
+};
 
 struct OverflowAnalysis : public llvm::PassInfoMixin<OverflowAnalysis> {
-  // Dataflow state: IN and OUT memory per instruction
-  std::map<llvm::Instruction *, OverflowMemory *> InMap;
-  std::map<llvm::Instruction *, OverflowMemory *> OutMap;
+  using Engine = DataflowEngine<OverflowLattice, OverflowAnalysis>;
 
   // Instructions that may overflow
   llvm::SetVector<llvm::Instruction *> ErrorInsts;
 
+  // Value numbering and instruction CFG of the function being analyzed,
+  // owned by this analysis or by the ProductAnalysis driving it
+  const ValueIndex *Index = nullptr;
+  const FunctionIndex *Graph = nullptr;
+
+  // Has the fixpoint driving transfer() evaluated a block yet? Values from
+  // the blocks it has not are Bottom.
+  std::function<bool(unsigned)> Reached;
+
+  // Dataflow state: OUT memory of each block's terminator and widened IN of
+  // each component head. Per-instruction memories are rebuilt on demand.
+  std::unique_ptr<Engine> Fixpoint;
+
+  // Pass parameters
+  DataflowOptions Options;
+
+  // Stream of the statistics printed by analyze()
+  llvm::raw_ostream *Log = &llvm::errs();
+
+  // Summaries of the callees, read at calls, and of the function analyzed,
+  // filled by analyze(); none if null
+  SummaryTable *Summaries = nullptr;
+
+  OverflowAnalysis(DataflowOptions Options = DataflowOptions())
+      : Options(Options) {}
+
   llvm::PreservedAnalyses run(llvm::Function &F,
                               llvm::FunctionAnalysisManager &);
 
+  // The three steps of run(): number F and query FAM for its loops, then
+  // solve F and check its instructions, then print the findings to Out.
+  // Only setup() uses the analysis manager.
+  void setup(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+  void analyze(llvm::Function &F);
+  void report(llvm::Function &F, llvm::raw_ostream &Out);
+
+  // Solve F again, after analyze(), with the argument intervals of Context
+  // instead of top ones, and summarize it for that context
+  FunctionSummary analyzeContext(llvm::Function &F, const CallContext &Context);
+
 protected:
-  // Transfer function: In -> NOut for a single instruction
+  friend Engine;
+  friend struct ProductAnalysis;
+
+  // Transfer function: In -> NOut for a single instruction, NOut starting
+  // as a copy of In
   void transfer(llvm::Instruction *I,
                 const OverflowMemory *In,
                 OverflowMemory &NOut);
 
-  // Chaotic iteration driver
-  void doAnalysis(llvm::Function &F);
+  // IN memory of the entry block: the arguments can be any value, or are
+  // as in the context of analyzeContext()
+  void entry(OverflowMemory &InMem);
 
-  // Flow IN: join predecessors' OUT into InMem
-  void flowIn(llvm::Instruction *Inst, OverflowMemory *InMem);
+  // Refine the OUT memory of block Pred by the branch condition of its edge
+  // to block B. Returns false if the edge is infeasible.
+  bool edge(unsigned Pred, unsigned B, OverflowMemory &Mem);
 
-  // Flow OUT: merge Pre and Post, update OutMap + workset
-  void flowOut(llvm::Instruction *Inst,
-               OverflowMemory *Pre,
-               OverflowMemory *Post,
-               llvm::SetVector<llvm::Instruction *> &WorkSet);
+  // Widening thresholds and delays, and closed-form induction variables of
+  // F, once Index and Graph are set
+  void prepare(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
 
-  // Can Inst incur an integer overflow or underflow?
-  bool check(llvm::Instruction *Inst);
+  // Fixpoint driver: recursive iteration strategy over the WTO
+  void doAnalysis(llvm::Function &F, const WeakTopologicalOrder &WTO);
+
+  // Can Inst incur an integer overflow or underflow? OutState gives the OUT
+  // memory of an instruction at the fixpoint, by number.
+  bool check(llvm::Instruction *Inst,
+             llvm::function_ref<const OverflowMemory &(unsigned)> OutState);
+
+  // Summarize F for its callers: the interval of the integers it returns,
+  // and the argument they are an offset of, if any
+  void summarize(llvm::Function &F,
+                 llvm::function_ref<const OverflowMemory &(unsigned)> OutState,
+                 FunctionSummary &Summary);
+
+  // Summary of the callee of Call, for the intervals of its arguments in In
+  // if call contexts are enabled; null if there is none
+  const FunctionSummary *callSummary(llvm::CallInst *Call,
+                                     const OverflowMemory *In);
+
+  // Add the intervals of the arguments of Call in In to Context
+  void addArguments(llvm::CallInst *Call, const OverflowMemory *In,
+                    CallContext &Context);
+
+  // Set the integer returned by Call in NOut from the summary of its callee
+  void applySummary(llvm::CallInst *Call, const FunctionSummary &Summary,
+                    const OverflowMemory *In, OverflowMemory &NOut);
 
   std::string getAnalysisName() { return "Overflow"; }
+
+private:
+  // Numbering and iteration order built by setup(), unless a
+  // ProductAnalysis shares its own
+  std::unique_ptr<ValueIndex> Values;
+  std::unique_ptr<FunctionIndex> Blocks;
+  std::unique_ptr<WeakTopologicalOrder> WTO;
+
+  // Joins before widening at the head of each block: Options.WidenDelay
+  // for the headers of LoopInfo loops, 0 for other cycles
+  std::vector<unsigned> WideningDelays;
+
+  // Sorted bounds that widening steps through before infinity
+  std::vector<long long> Thresholds;
+
+  // Closed-form intervals of the loop-header PHIs that ScalarEvolution
+  // solves; these PHIs take no part in the fixpoint
+  llvm::DenseMap<VarId, overflow::DomainOverflow> InductionRanges;
+
+  // Arguments of the context solved by analyzeContext(), or null while the
+  // arguments can be any value
+  const CallContext *EntryContext = nullptr;
+
+  // Contexts admitted at the calls of the current solve
+  ContextSlots Slots;
 };
 
 } // namespace dataflow
@@ -0,0 +1,170 @@
+#ifndef PARALLEL_DRIVER_H
+#define PARALLEL_DRIVER_H
+
+#include "DataflowOptions.h"
+#include "FunctionSummary.h"
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dataflow {
+
+/**
+ * @brief Module pass running the function analysis AnalysisT on every
+ * defined function, Options.Threads functions at a time.
+ *
+ * AnalysisT splits its run() in three steps:
+ *
+ *   // Number F and query the analysis manager.
+ *   void setup(Function &F, FunctionAnalysisManager &FAM);
+ *   // Solve F and check its instructions, printing diagnostics to *Log.
+ *   void analyze(Function &F);
+ *   // Print the findings of analyze() to Out.
+ *   void report(Function &F, raw_ostream &Out);
+ *
+ * The analysis manager is not thread-safe, so every function is set up on
+ * this thread before any is analyzed. Each function then gets an AnalysisT
+ * of its own and is analyzed on the pool, the largest functions first so
+ * that no large one starts last. The diagnostics of each function are kept
+ * in a string, and they and the findings are printed in the order of the
+ * functions in the module, as soon as the functions before are done.
+ *
+ * With Options.Summaries, AnalysisT reads the summaries of the callees from
+ * its Summaries table and fills the one of F. The functions are then
+ * analyzed level by level of the table, each level on the pool once the
+ * levels below are done.
+ *
+ * With Options.Contexts, AnalysisT also has
+ *
+ *   // Solve F again for the arguments of Context, after analyze().
+ *   FunctionSummary analyzeContext(Function &F, const CallContext &Context);
+ *
+ * which the table calls, on the thread of the caller, for each new context
+ * of F. The analyses are then kept until every function is done.
+ */
+template <typename AnalysisT>
+struct ParallelDriver : public llvm::PassInfoMixin<ParallelDriver<AnalysisT>> {
+  DataflowOptions Options;
+
+  ParallelDriver(DataflowOptions Options = DataflowOptions()) : Options(Options) {}
+
+  llvm::PreservedAnalyses run(llvm::Module &M, llvm::ModuleAnalysisManager &MAM) {
+    llvm::FunctionAnalysisManager &FAM =
+        MAM.getResult<llvm::FunctionAnalysisManagerModuleProxy>(M).getManager();
+
+    if (Options.Threads <= 1 && !Options.Summaries) {
+      for (llvm::Function &F : M) {
+        if (!F.isDeclaration())
+          AnalysisT(Options).run(F, FAM);
+      }
+      return llvm::PreservedAnalyses::all();
+    }
+
+    std::unique_ptr<SummaryTable> Summaries;
+    if (Options.Summaries)
+      Summaries = std::make_unique<SummaryTable>(
+          MAM.getResult<llvm::CallGraphAnalysis>(M), Options.Contexts);
+
+    std::vector<std::unique_ptr<Task>> Tasks;
+    llvm::DenseMap<const llvm::Function *, Task *> TaskOf;
+    for (llvm::Function &F : M) {
+      if (F.isDeclaration())
+        continue;
+      Tasks.push_back(std::make_unique<Task>(F, Options));
+      Tasks.back()->Analysis.Summaries = Summaries.get();
+      Tasks.back()->Analysis.setup(F, FAM);
+      TaskOf[&F] = Tasks.back().get();
+      if (Options.Contexts) {
+        Summaries->setAnalyzer(F, [T = Tasks.back().get()](const CallContext &Context) {
+          return T->Analysis.analyzeContext(T->F, Context);
+        });
+      }
+    }
+
+    // Without summaries the functions are independent: one level.
+    std::vector<std::vector<Task *>> Levels;
+    if (Summaries) {
+      for (const std::vector<llvm::Function *> &Level : Summaries->levels()) {
+        Levels.emplace_back();
+        for (llvm::Function *F : Level)
+          Levels.back().push_back(TaskOf[F]);
+      }
+    } else {
+      Levels.emplace_back();
+      for (auto &T : Tasks)
+        Levels.back().push_back(T.get());
+    }
+
+    // Print the functions done, in module order, up to the first that is
+    // not, or wait for every function.
+    size_t Reported = 0;
+    auto Report = [&](bool Wait) {
+      for (; Reported < Tasks.size(); ++Reported) {
+        std::unique_ptr<Task> &T = Tasks[Reported];
+        if (!Wait && !T->Done.valid())
+          return;
+        T->Done.wait();
+        llvm::errs() << T->Log;
+        T->Analysis.report(T->F, llvm::outs());
+        T.reset();
+      }
+    };
+
+    llvm::ThreadPool Pool(llvm::hardware_concurrency(Options.Threads));
+    for (size_t L = 0; L < Levels.size(); ++L) {
+      std::vector<Task *> &Level = Levels[L];
+      std::stable_sort(Level.begin(), Level.end(), [](const Task *A, const Task *B) {
+        return A->F.getInstructionCount() > B->F.getInstructionCount();
+      });
+      for (Task *T : Level) {
+        T->Done = Pool.async([T] {
+          llvm::raw_string_ostream Log(T->Log);
+          T->Analysis.Log = &Log;
+          T->Analysis.analyze(T->F);
+          T->Analysis.Log = &llvm::errs();
+        });
+      }
+
+      // The next level reads the summaries of this one, and may analyze
+      // its functions again for new contexts.
+      if (L + 1 < Levels.size()) {
+        for (Task *T : Level)
+          T->Done.wait();
+        if (!Options.Contexts)
+          Report(false);
+      }
+    }
+    // A function stays alive until its callers are done with its contexts.
+    if (Options.Contexts)
+      Pool.wait();
+    Report(true);
+    return llvm::PreservedAnalyses::all();
+  }
+
+ private:
+  /**
+   * @brief The analysis of one function and its buffered diagnostics.
+   */
+  struct Task {
+    llvm::Function &F;
+    AnalysisT Analysis;
+    std::string Log;
+    std::shared_future<void> Done;
+
+    Task(llvm::Function &F, const DataflowOptions &Options) : F(F), Analysis(Options) {}
+  };
+};
+
+}  // namespace dataflow
+
+#endif  // PARALLEL_DRIVER_H
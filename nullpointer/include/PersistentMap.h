@@ -0,0 +1,438 @@
+#ifndef PERSISTENT_MAP_H
+#define PERSISTENT_MAP_H
+
+#include "ValueIndex.h"
+#include "llvm/Support/MathExtras.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Persistent Abstract Memory
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief A persistent map from variable IDs to lattice elements of type T.
+ *
+ * The map is a hash array mapped trie indexed directly by the bits of the
+ * (dense) variable ID, five bits per level starting from the least
+ * significant ones. Nodes are reference counted and shared between maps:
+ * copying a map is O(1), and updating one variable copies only the O(log n)
+ * nodes on its path. A node that is owned by a single map is updated in place.
+ *
+ * T must be trivially copyable and provide static T::join(A, B) and
+ * T::equal(A, B), like Domain and DomainOverflow do. Reference counts are not
+ * atomic, so maps sharing nodes must stay on one thread.
+ */
+template <typename T> class PersistentMap {
+  static_assert(std::is_trivially_copyable<T>::value,
+      "PersistentMap stores lattice elements by value");
+
+  static constexpr unsigned Bits = 5;
+  static constexpr unsigned Mask = (1u << Bits) - 1;
+  static constexpr unsigned MaxSlots = 1u << Bits;
+
+  struct Node;
+
+  // A slot holds either one entry (Child == nullptr) or a child node.
+  struct Slot {
+    Node *Child;
+    VarId Key;
+    T Value;
+  };
+
+  struct alignas(Slot) Node {
+    unsigned RefCount;
+    uint32_t Bitmap;
+
+    Slot *slots() { return reinterpret_cast<Slot *>(this + 1); }
+    unsigned count() const { return llvm::countPopulation(Bitmap); }
+  };
+
+ public:
+  PersistentMap() = default;
+  PersistentMap(const PersistentMap &Other) : Root(Other.Root) { retain(Root); }
+  PersistentMap(PersistentMap &&Other) : Root(Other.Root) { Other.Root = nullptr; }
+  ~PersistentMap() { release(Root); }
+
+  PersistentMap &operator=(const PersistentMap &Other) {
+    retain(Other.Root);
+    release(Root);
+    Root = Other.Root;
+    return *this;
+  }
+
+  PersistentMap &operator=(PersistentMap &&Other) {
+    std::swap(Root, Other.Root);
+    return *this;
+  }
+
+  bool empty() const { return Root == nullptr; }
+
+  void clear() {
+    release(Root);
+    Root = nullptr;
+  }
+
+  /**
+   * @brief Get the element of Key, or nullptr if Key is not in the map.
+   */
+  const T *find(VarId Key) const {
+    Node *N = Root;
+    for (unsigned Shift = 0; N; Shift += Bits) {
+      uint32_t Bit = 1u << ((Key >> Shift) & Mask);
+      if (!(N->Bitmap & Bit))
+        return nullptr;
+      Slot &S = N->slots()[llvm::countPopulation(N->Bitmap & (Bit - 1))];
+      if (!S.Child)
+        return S.Key == Key ? &S.Value : nullptr;
+      N = S.Child;
+    }
+    return nullptr;
+  }
+
+  bool count(VarId Key) const { return find(Key) != nullptr; }
+
+  /**
+   * @brief Map Key to Value, copying only the nodes on the path to Key that
+   * are shared with other maps.
+   */
+  void set(VarId Key, const T &Value) {
+    if (!Root) {
+      Root = makeEntry(Key, Value, 0);
+      return;
+    }
+    Root = insert(Root, Key, Value, 0);
+  }
+
+  /**
+   * @brief Call F(Key, Value) for every entry, in ascending order of Key.
+   */
+  template <typename Fn> void forEach(Fn F) const {
+    std::vector<std::pair<VarId, T>> Entries;
+    collect(Root, Entries);
+    std::sort(Entries.begin(), Entries.end(),
+        [](const std::pair<VarId, T> &A, const std::pair<VarId, T> &B) {
+          return A.first < B.first;
+        });
+    for (auto &E : Entries)
+      F(E.first, E.second);
+  }
+
+  /**
+   * @brief Join A and B pointwise with T::join.
+   *
+   * A variable present in only one of the maps keeps its element if Missing
+   * is nullptr, and is joined with *Missing otherwise. Subtrees shared by A
+   * and B are reused without being visited.
+   */
+  static PersistentMap join(
+      const PersistentMap &A, const PersistentMap &B, const T *Missing = nullptr) {
+    return merge(A, B, [](const T &X, const T &Y) { return T::join(X, Y); }, Missing);
+  }
+
+  /**
+   * @brief Combine A and B pointwise with Combine(ElementOfA, ElementOfB).
+   *
+   * Combine must return X when applied to (X, X), e.g. a widening. Variables
+   * present in only one of the maps are handled as in join().
+   */
+  template <typename Fn>
+  static PersistentMap merge(const PersistentMap &A,
+      const PersistentMap &B,
+      Fn Combine,
+      const T *Missing = nullptr) {
+    PersistentMap Result;
+    if (!A.Root) {
+      Result.Root = Missing ? joinMissing(B.Root, *Missing) : retain(B.Root);
+    } else if (!B.Root) {
+      Result.Root = Missing ? joinMissing(A.Root, *Missing) : retain(A.Root);
+    } else {
+      Result.Root = mergeNodes(A.Root, B.Root, Combine, Missing, 0);
+    }
+    return Result;
+  }
+
+  /**
+   * @brief Compare A and B pointwise with T::equal.
+   *
+   * A variable present in only one of the maps makes them unequal if Missing
+   * is nullptr, and is compared to *Missing otherwise. Shared subtrees are
+   * equal without being visited.
+   */
+  static bool equal(
+      const PersistentMap &A, const PersistentMap &B, const T *Missing = nullptr) {
+    if (!A.Root || !B.Root) {
+      Node *N = A.Root ? A.Root : B.Root;
+      return !N || (Missing && allEqual(N, *Missing));
+    }
+    return equalNodes(A.Root, B.Root, Missing, 0);
+  }
+
+ private:
+  Node *Root = nullptr;
+
+  static Node *allocate(unsigned Count) {
+    void *Mem = ::operator new(sizeof(Node) + Count * sizeof(Slot));
+    Node *N = new (Mem) Node;
+    N->RefCount = 1;
+    N->Bitmap = 0;
+    return N;
+  }
+
+  static Node *retain(Node *N) {
+    if (N)
+      ++N->RefCount;
+    return N;
+  }
+
+  static void release(Node *N) {
+    if (!N || --N->RefCount != 0)
+      return;
+    Slot *Slots = N->slots();
+    for (unsigned I = 0, E = N->count(); I != E; ++I)
+      release(Slots[I].Child);
+    ::operator delete(N);
+  }
+
+  static Node *copy(Node *N) {
+    unsigned Count = N->count();
+    Node *R = allocate(Count);
+    R->Bitmap = N->Bitmap;
+    std::copy(N->slots(), N->slots() + Count, R->slots());
+    for (unsigned I = 0; I != Count; ++I)
+      retain(R->slots()[I].Child);
+    return R;
+  }
+
+  // Make a node from up to MaxSlots slots given in bit order.
+  static Node *build(uint32_t Bitmap, const Slot *Slots) {
+    Node *R = allocate(llvm::countPopulation(Bitmap));
+    R->Bitmap = Bitmap;
+    std::copy(Slots, Slots + llvm::countPopulation(Bitmap), R->slots());
+    return R;
+  }
+
+  static Node *makeEntry(VarId Key, const T &Value, unsigned Shift) {
+    Slot S{nullptr, Key, Value};
+    return build(1u << ((Key >> Shift) & Mask), &S);
+  }
+
+  // Make a node holding two entries with distinct keys.
+  static Node *makePair(const Slot &S1, const Slot &S2, unsigned Shift) {
+    unsigned B1 = (S1.Key >> Shift) & Mask;
+    unsigned B2 = (S2.Key >> Shift) & Mask;
+    if (B1 == B2) {
+      Slot S{makePair(S1, S2, Shift + Bits), 0, T()};
+      return build(1u << B1, &S);
+    }
+    Slot Slots[2] = {B1 < B2 ? S1 : S2, B1 < B2 ? S2 : S1};
+    return build((1u << B1) | (1u << B2), Slots);
+  }
+
+  // Insert into N, consuming the caller's reference to N and returning a
+  // reference to the updated node.
+  static Node *insert(Node *N, VarId Key, const T &Value, unsigned Shift) {
+    uint32_t Bit = 1u << ((Key >> Shift) & Mask);
+    unsigned Pos = llvm::countPopulation(N->Bitmap & (Bit - 1));
+
+    if (!(N->Bitmap & Bit)) {
+      unsigned Count = N->count();
+      Slot Slots[MaxSlots];
+      std::copy(N->slots(), N->slots() + Pos, Slots);
+      Slots[Pos] = Slot{nullptr, Key, Value};
+      std::copy(N->slots() + Pos, N->slots() + Count, Slots + Pos + 1);
+      Node *R = build(N->Bitmap | Bit, Slots);
+      for (unsigned I = 0; I != Count + 1; ++I)
+        retain(R->slots()[I].Child);
+      release(N);
+      return R;
+    }
+
+    Slot &S = N->slots()[Pos];
+    if (S.Child) {
+      if (N->RefCount == 1) {
+        S.Child = insert(S.Child, Key, Value, Shift + Bits);
+        return N;
+      }
+      Node *Child = insert(retain(S.Child), Key, Value, Shift + Bits);
+      if (Child == S.Child) {
+        release(Child);
+        return N;
+      }
+      Node *R = copy(N);
+      release(R->slots()[Pos].Child);
+      R->slots()[Pos].Child = Child;
+      release(N);
+      return R;
+    }
+
+    if (S.Key == Key && T::equal(S.Value, Value))
+      return N;
+
+    Node *R = N->RefCount == 1 ? N : copy(N);
+    Slot &RS = R->slots()[Pos];
+    if (RS.Key == Key)
+      RS.Value = Value;
+    else
+      RS.Child = makePair(RS, Slot{nullptr, Key, Value}, Shift + Bits);
+    if (R != N)
+      release(N);
+    return R;
+  }
+
+  static void collect(Node *N, std::vector<std::pair<VarId, T>> &Entries) {
+    if (!N)
+      return;
+    Slot *Slots = N->slots();
+    for (unsigned I = 0, E = N->count(); I != E; ++I) {
+      if (Slots[I].Child)
+        collect(Slots[I].Child, Entries);
+      else
+        Entries.emplace_back(Slots[I].Key, Slots[I].Value);
+    }
+  }
+
+  // Join every element of N with Missing, reusing N if nothing changes.
+  static Node *joinMissing(Node *N, const T &Missing) {
+    if (!N)
+      return nullptr;
+    unsigned Count = N->count();
+    Slot Slots[MaxSlots];
+    bool Same = true;
+    for (unsigned I = 0; I != Count; ++I) {
+      const Slot &S = N->slots()[I];
+      if (S.Child) {
+        Node *Child = joinMissing(S.Child, Missing);
+        Slots[I] = Slot{Child, 0, T()};
+        Same &= Child == S.Child;
+      } else {
+        T Value = T::join(S.Value, Missing);
+        Slots[I] = Slot{nullptr, S.Key, Value};
+        Same &= T::equal(Value, S.Value);
+      }
+    }
+    return finish(N->Bitmap, Slots, Same ? N : nullptr, nullptr);
+  }
+
+  // Turn the slot S of a node at Shift into a node one level down, so that
+  // it can be merged or compared with a child node.
+  static Node *asNode(const Slot &S, unsigned Shift) {
+    return S.Child ? retain(S.Child) : makeEntry(S.Key, S.Value, Shift);
+  }
+
+  template <typename Fn>
+  static Node *mergeNodes(Node *A, Node *B, Fn &Combine, const T *Missing, unsigned Shift) {
+    if (A == B)
+      return retain(A);
+
+    uint32_t Bitmap = A->Bitmap | B->Bitmap;
+    Slot Slots[MaxSlots];
+    bool SameA = Bitmap == A->Bitmap;
+    bool SameB = Bitmap == B->Bitmap;
+    unsigned I = 0, IA = 0, IB = 0;
+    for (uint32_t Rest = Bitmap; Rest; Rest &= Rest - 1, ++I) {
+      uint32_t Bit = Rest & -Rest;
+      const Slot *SA = (A->Bitmap & Bit) ? &A->slots()[IA++] : nullptr;
+      const Slot *SB = (B->Bitmap & Bit) ? &B->slots()[IB++] : nullptr;
+      Slot &R = Slots[I];
+
+      if (!SA || !SB) {
+        const Slot *S = SA ? SA : SB;
+        if (!Missing) {
+          R = *S;
+          retain(R.Child);
+        } else if (S->Child) {
+          R = Slot{joinMissing(S->Child, *Missing), 0, T()};
+        } else {
+          R = Slot{nullptr, S->Key, T::join(S->Value, *Missing)};
+        }
+      } else if (!SA->Child && !SB->Child && SA->Key == SB->Key) {
+        R = Slot{nullptr, SA->Key, Combine(SA->Value, SB->Value)};
+      } else if (!SA->Child && !SB->Child && !Missing) {
+        R = Slot{makePair(*SA, *SB, Shift + Bits), 0, T()};
+      } else {
+        Node *NA = asNode(*SA, Shift + Bits);
+        Node *NB = asNode(*SB, Shift + Bits);
+        R = Slot{mergeNodes(NA, NB, Combine, Missing, Shift + Bits), 0, T()};
+        release(NA);
+        release(NB);
+      }
+
+      SameA &= SA && sameSlot(R, *SA);
+      SameB &= SB && sameSlot(R, *SB);
+    }
+    return finish(Bitmap, Slots, SameA ? A : nullptr, SameB ? B : nullptr);
+  }
+
+  static bool sameSlot(const Slot &R, const Slot &S) {
+    if (R.Child || S.Child)
+      return R.Child == S.Child;
+    return R.Key == S.Key && T::equal(R.Value, S.Value);
+  }
+
+  // Return a node for the given slots, which hold one reference to each of
+  // their children. Reuse A or B instead if they are identical.
+  static Node *finish(uint32_t Bitmap, Slot *Slots, Node *A, Node *B) {
+    Node *Reuse = A ? A : B;
+    if (!Reuse)
+      return build(Bitmap, Slots);
+    for (unsigned I = 0, E = llvm::countPopulation(Bitmap); I != E; ++I)
+      release(Slots[I].Child);
+    return retain(Reuse);
+  }
+
+  static bool allEqual(Node *N, const T &Missing) {
+    Slot *Slots = N->slots();
+    for (unsigned I = 0, E = N->count(); I != E; ++I) {
+      if (Slots[I].Child ? !allEqual(Slots[I].Child, Missing)
+                         : !T::equal(Slots[I].Value, Missing))
+        return false;
+    }
+    return true;
+  }
+
+  static bool equalNodes(Node *A, Node *B, const T *Missing, unsigned Shift) {
+    if (A == B)
+      return true;
+    if (!Missing && A->Bitmap != B->Bitmap)
+      return false;
+
+    unsigned IA = 0, IB = 0;
+    for (uint32_t Rest = A->Bitmap | B->Bitmap; Rest; Rest &= Rest - 1) {
+      uint32_t Bit = Rest & -Rest;
+      const Slot *SA = (A->Bitmap & Bit) ? &A->slots()[IA++] : nullptr;
+      const Slot *SB = (B->Bitmap & Bit) ? &B->slots()[IB++] : nullptr;
+
+      if (!SA || !SB) {
+        const Slot *S = SA ? SA : SB;
+        if (S->Child ? !allEqual(S->Child, *Missing) : !T::equal(S->Value, *Missing))
+          return false;
+      } else if (!SA->Child && !SB->Child && SA->Key == SB->Key) {
+        if (!T::equal(SA->Value, SB->Value))
+          return false;
+      } else if (!SA->Child && !SB->Child && !Missing) {
+        return false;
+      } else {
+        Node *NA = asNode(*SA, Shift + Bits);
+        Node *NB = asNode(*SB, Shift + Bits);
+        bool Equal = equalNodes(NA, NB, Missing, Shift + Bits);
+        release(NA);
+        release(NB);
+        if (!Equal)
+          return false;
+      }
+    }
+    return true;
+  }
+};
+
+}  // namespace dataflow
+
+#endif  // PERSISTENT_MAP_H
@@ -1,10 +1,19 @@
 #ifndef POINTER_ANALYSIS_H
 #define POINTER_ANALYSIS_H
 
+#include "DataflowOptions.h"
+#include "PointsToCache.h"
+#include "ValueIndex.h"
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/BitVector.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/PassManager.h"
+#include "llvm/Support/raw_ostream.h"
 
-#include <map>
-#include <set>
+#include <memory>
+#include <vector>
 
 using namespace llvm;
 
@@ -14,60 +23,266 @@ namespace dataflow {
 // Pointer Analysis
 //===----------------------------------------------------------------------===//
 
-using PointsToSet = std::set<std::string>;
-
 /**
- * @brief PointsToInfo represents the set of allocation sites a variable can point to. 
+ * @brief Flow-insensitive pointer analysis of one function.
  *
+ * Every alloca is an allocation site. Allocas, stores and loads of pointers
+ * are turned into constraints, which the subclasses solve into points-to
+ * sets; alias queries are answered from these sets. The sets are hash-consed
+ * in a PointsToCache, so pointers with the same sites share one set.
  */
-using PointsToInfo = std::map<std::string, PointsToSet>;
 class PointerAnalysis {
  public:
+  virtual ~PointerAnalysis() = default;
+
   /**
-   * @brief Build a points-to graph
+   * @brief Returns true if two pointers are aliased
    *
-   * This constructor applies the pointer analysis transfer function
-   * on each instruction in function F.
+   * @param Ptr1 First pointer
+   * @param Ptr2 Second pointer
+   * @return bool  
+   */
+  bool alias(VarId Ptr1, VarId Ptr2) const;
+
+  /**
+   * @brief Returns the allocas that a pointer may alias
    *
-   * @param F The function for which pointer analysis is done
+   * The rows are computed once, when the points-to sets are stable, so this is
+   * a single lookup: the allocas A with alias(Ptr, A), by increasing ID.
+   *
+   * @param Ptr The pointer
+   * @return const std::vector<VarId>& IDs of the allocas aliased by Ptr
    */
-  PointerAnalysis(Function &F);
+  const std::vector<VarId> &aliasedAllocas(VarId Ptr) const;
 
   /**
-   * @brief If the instruction is memory allocation, store, or load, updates the points-to sets.
+   * @brief Returns true if the address of an alloca escapes
+   *
+   * The address of a non-escaping alloca is only used as the pointer operand
+   * of loads and stores, so no other pointer can reach it: even a dynamic
+   * one is a single object to the stores through it.
    *
-   * @param Inst The instruction to be analyzed for aliasing
-   * @param PointsTo The set of 
+   * @param Alloca ID of the alloca
+   * @return bool
    */
-  void transfer(Instruction *Inst, PointsToInfo &PointsTo);
+  bool escapes(VarId Alloca) const { return Escaping.test(Alloca); }
 
   /**
-   * @brief Returns true if two pointers are aliased
+   * @brief Print the size of the constraint graph before and after the
+   * offline reduction, and the number of distinct points-to sets.
+   */
+  void printStats(raw_ostream &OS) const;
+
+  /**
+   * @brief Print the points-to sets to OS.
+   */
+  void print(raw_ostream &OS);
+
+ protected:
+  /**
+   * @brief A pointer constraint.
+   */
+  struct Constraint {
+    // Dst and Src are pointer nodes, except for the site of AddressOf.
+    enum KindTy {
+      // Dst points to site Src.
+      AddressOf,
+      // Dst = *Src
+      Load,
+      // *Dst = Src
+      Store,
+    };
+    KindTy Kind;
+    unsigned Dst;
+    unsigned Src;
+  };
+
+  using SetRef = PointsToCache::SetRef;
+
+  const ValueIndex &Index;
+
+  /**
+   * @brief Points-to sets of the analysis, stored once each.
+   */
+  PointsToCache Cache;
+
+  /**
+   * @brief ID of the alloca of each allocation site.
+   */
+  std::vector<VarId> Sites;
+
+  /**
+   * @brief Variables that occur in a constraint, and the ones loaded or
+   * stored through.
+   */
+  BitVector Constrained;
+  BitVector Dereferenced;
+
+  /**
+   * @brief Allocas whose address is stored, passed or cast.
+   */
+  BitVector Escaping;
+
+  static const unsigned NoNode = ~0u;
+
+  /**
+   * @brief Pointer node of each variable, or NoNode if it points to no site.
+   * Variables that provably point to the same sites share a node.
+   */
+  std::vector<unsigned> NodeOf;
+  unsigned NumNodes = 0;
+
+  /**
+   * @brief Node of the loads through each pointer node.
+   */
+  DenseMap<unsigned, unsigned> LoadNodes;
+
+  PointerAnalysis(const ValueIndex &Index)
+      : Index(Index),
+        Constrained(Index.size()),
+        Dereferenced(Index.size()),
+        Escaping(Index.size()) {}
+
+  /**
+   * @brief Number the allocation sites of F, in layout order, mark the ones
+   * that escape, and collect the constraints of its allocas, stores and loads
+   * over pointer nodes.
    *
-   * @param Ptr1 First pointer
-   * @param Ptr2 Second pointer
-   * @return bool  
+   * Before the constraints are solved, the variables are numbered offline
+   * (hash-based value numbering): an alloca gets a new number, and a load
+   * through a pointer numbered P gets the number shared by all loads through
+   * pointers numbered P. Variables with the same number point to the same
+   * sites, so they become one node, and constraints that become identical
+   * are dropped. Other variables, such as arguments and constants, point to
+   * no site, and their constraints are dropped as well.
+   *
+   * @param F The function for which pointer analysis is done
+   * @return std::vector<Constraint> The constraints, in layout order
    */
-  bool alias(std::string &Ptr1, std::string &Ptr2) const;
+  std::vector<Constraint> collectConstraints(Function &F);
 
- private:
-  PointsToInfo PointsTo;
+  /**
+   * @brief Get the node of Val, numbering it first if it is an alloca or a
+   * load of a pointer not numbered yet.
+   */
+  unsigned number(Value *Val);
 
   /**
-   * @brief 
+   * @brief Get the constraint of instruction I over the nodes of its
+   * operands, and mark the variables it constrains. An alloca gets the next
+   * allocation site.
    *
-   * @param PointsTo 
-   * @return int 
+   * @return bool true if I is an alloca or a store or load of a pointer. The
+   * constraint is dropped if Dst or Src is NoNode.
+   */
+  bool constraintOf(Instruction &I, Constraint &C);
+
+  /**
+   * @brief Is the address of Alloca used other than as the pointer operand of
+   * a load or store, not counting the uses by Erased?
+   */
+  static bool addressEscapes(const AllocaInst *Alloca, const Instruction *Erased = nullptr);
+
+  /**
+   * @brief Points-to set of pointer node N once the constraints are solved.
+   */
+  virtual SetRef pointsToNode(unsigned N) const = 0;
+
+  /**
+   * @brief Points-to set of the pointers stored at allocation site Site.
+   */
+  virtual SetRef contents(unsigned Site) const = 0;
+
+  /**
+   * @brief Fill AliasTable from the solved points-to sets.
+   */
+  void finish();
+
+  /**
+   * @brief Update the rows of the pointer nodes in Changed, whose sets
+   * changed since the last update, and give new nodes the empty row.
+   */
+  void finish(ArrayRef<unsigned> Changed);
+
+ private:
+  /**
+   * @brief Allocas aliased by each distinct points-to set, the row of each
+   * set, and the row of each pointer node.
+   */
+  std::vector<std::vector<VarId>> AliasTable;
+  DenseMap<SetRef, unsigned> Rows;
+  std::vector<unsigned> RowOf;
+  std::vector<VarId> NoAliases;
+
+  // Size of the constraint graph before and after the offline reduction.
+  unsigned VarsBefore = 0;
+  unsigned ConstraintsBefore = 0;
+  unsigned ConstraintsAfter = 0;
+
+  /**
+   * @brief Points-to set of variable Var once the constraints are solved.
    */
-  int countFacts(PointsToInfo &PointsTo);
+  SetRef pointsTo(VarId Var) const;
 
   /**
-   * @brief 
+   * @brief Row of AliasTable for the set Pts, added if it is new.
+   */
+  unsigned row(SetRef Pts);
+};
+
+/**
+ * @brief The pointer analyses of one function and the value numbering their
+ * IDs refer to, each solved on its first request and shared by every pass
+ * until the function changes.
+ */
+class PointerAnalysisResult {
+ public:
+  PointerAnalysisResult(Function &F) : Func(&F), Index(std::make_unique<ValueIndex>(F)) {}
+
+  /**
+   * @brief Value numbering of the function, whose IDs the analyses take.
+   */
+  const ValueIndex &index() const { return *Index; }
+
+  /**
+   * @brief Get the analysis Mode of the function, solving it on the first
+   * request.
    *
-   * @param PointsTo 
+   * @param Mode The analysis, other than Auto
+   * @param Threads Number of threads solving Andersen constraints, if they
+   * are not solved yet
+   * @return PointerAnalysis& The solved analysis
    */
-  void print(std::map<std::string, PointsToSet> &PointsTo);
+  PointerAnalysis &get(PointerMode Mode, unsigned Threads = 1);
+
+  /**
+   * @brief The analyses only depend on the instructions of the function, so
+   * they stay valid as long as the pass preserved them or all analyses.
+   */
+  bool invalidate(Function &F, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &);
+
+ private:
+  Function *Func;
+  std::unique_ptr<ValueIndex> Index;
+  // Solved analyses, by mode.
+  std::unique_ptr<PointerAnalysis> Analyses[unsigned(PointerMode::Auto)];
+};
+
+/**
+ * @brief New pass manager analysis giving the PointerAnalysisResult of a
+ * function: FAM.getResult<PointerAnalysisPass>(F).get(Mode).
+ */
+class PointerAnalysisPass : public AnalysisInfoMixin<PointerAnalysisPass> {
+ public:
+  using Result = PointerAnalysisResult;
+
+  Result run(Function &F, FunctionAnalysisManager &) { return Result(F); }
+
+ private:
+  friend AnalysisInfoMixin<PointerAnalysisPass>;
+  static AnalysisKey Key;
 };
+
 };  // namespace dataflow
 
 #endif  // POINTER_ANALYSIS_H
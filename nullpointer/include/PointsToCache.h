@@ -0,0 +1,87 @@
+#ifndef POINTS_TO_CACHE_H
+#define POINTS_TO_CACHE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SparseBitVector.h"
+
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+
+using namespace llvm;
+
+namespace dataflow {
+
+/**
+ * @brief The allocation sites a pointer can point to, by site number.
+ */
+using PointsToSet = SparseBitVector<>;
+
+/**
+ * @brief Hash-consing table of points-to sets.
+ *
+ * Every set is stored once and handed out as a pointer, so two handles from
+ * the same table are equal exactly when their sets are, and pointers with
+ * the same points-to set share its storage. Sets are never modified or freed
+ * while the table lives; an operation returns the handle of its result, and
+ * is remembered for each pair of operands, so repeating it is a lookup.
+ *
+ * The table may be used from several threads at once.
+ */
+class PointsToCache {
+ public:
+  using SetRef = const PointsToSet *;
+
+  PointsToCache();
+
+  /**
+   * @brief The handle of the empty set.
+   */
+  SetRef empty() const { return Empty; }
+
+  /**
+   * @brief The handle of a set equal to S.
+   */
+  SetRef intern(const PointsToSet &S);
+
+  /**
+   * @brief The handles of A | B, A & ~B and A & B.
+   */
+  SetRef unite(SetRef A, SetRef B);
+  SetRef subtract(SetRef A, SetRef B);
+  SetRef intersect(SetRef A, SetRef B);
+
+  /**
+   * @brief Number of distinct sets stored.
+   */
+  size_t size() const;
+
+ private:
+  struct SetHash {
+    size_t operator()(const PointsToSet &S) const;
+  };
+
+  using Operands = std::pair<SetRef, SetRef>;
+
+  // The sets live in the nodes of the hash table, whose addresses do not
+  // change when it grows.
+  std::unordered_set<PointsToSet, SetHash> Sets;
+  DenseMap<Operands, SetRef> Unions;
+  DenseMap<Operands, SetRef> Differences;
+  DenseMap<Operands, SetRef> Intersections;
+  SetRef Empty;
+  mutable std::mutex Lock;
+
+  SetRef internLocked(const PointsToSet &S);
+
+  /**
+   * @brief Look up the result of an operation on A and B in Memo, or compute
+   * it with Op, without the lock held, and remember it.
+   */
+  template <typename OpTy>
+  SetRef memoize(DenseMap<Operands, SetRef> &Memo, SetRef A, SetRef B, OpTy Op);
+};
+
+}  // namespace dataflow
+
+#endif  // POINTS_TO_CACHE_H
@@ -0,0 +1,165 @@
+#ifndef PRODUCT_ANALYSIS_H
+#define PRODUCT_ANALYSIS_H
+
+#include "DataflowEngine.h"
+#include "DataflowOptions.h"
+#include "DivZeroAnalysis.h"
+#include "Domain.h"
+#include "FunctionIndex.h"
+#include "FunctionSummary.h"
+#include "NullPointerAnalysis.h"
+#include "OverflowAnalysis.h"
+#include "WeakTopologicalOrder.h"
+
+#include "llvm/IR/Function.h"
+#include "llvm/IR/PassManager.h"
+
+#include <memory>
+#include <string>
+
+namespace dataflow {
+
+/**
+ * @brief The memories of the three analyses at one program point.
+ */
+struct ProductMemory {
+  Memory Null;
+  Memory Zero;
+  OverflowMemory Ovf;
+
+  void clear() {
+    Null.clear();
+    Zero.clear();
+    Ovf.clear();
+  }
+};
+
+/**
+ * @brief Lattice of product memories, for DataflowEngine: every operation
+ * applies to each component.
+ *
+ * The Domain components have finite height, so they are joined where the
+ * intervals are widened, and keep their value where the intervals are
+ * narrowed.
+ */
+struct ProductLattice {
+  using Memory = ProductMemory;
+
+  DomainLattice Finite;
+  OverflowLattice Intervals;
+
+  Memory join(const Memory &A, const Memory &B) const {
+    return {Finite.join(A.Null, B.Null), Finite.join(A.Zero, B.Zero),
+        Intervals.join(A.Ovf, B.Ovf)};
+  }
+
+  Memory widen(const Memory &Old, const Memory &New) const {
+    return {Finite.join(Old.Null, New.Null), Finite.join(Old.Zero, New.Zero),
+        Intervals.widen(Old.Ovf, New.Ovf)};
+  }
+
+  Memory narrow(const Memory &Old, const Memory &New) const {
+    return {Old.Null, Old.Zero, Intervals.narrow(Old.Ovf, New.Ovf)};
+  }
+
+  bool equal(const Memory &A, const Memory &B) const {
+    return Intervals.equal(A.Ovf, B.Ovf) && Finite.equal(A.Null, B.Null) &&
+           Finite.equal(A.Zero, B.Zero);
+  }
+};
+
+/**
+ * @brief Null pointer, overflow and division by zero analysis in one
+ * fixpoint.
+ *
+ * The function is numbered once, and its blocks are iterated once in weak
+ * topological order, each visit applying the transfer functions of the
+ * three analyses to their component of a ProductMemory. The findings of each
+ * analysis are reported as its own pass reports them.
+ *
+ * The product is reduced on edges: a branch that one analysis proves cannot
+ * be taken is taken by none, so the results can be more precise than the
+ * ones of the analyses run apart.
+ */
+struct ProductAnalysis : public llvm::PassInfoMixin<ProductAnalysis> {
+  using Engine = DataflowEngine<ProductLattice, ProductAnalysis>;
+
+  NullPointerAnalysis Null;
+  OverflowAnalysis Ovf;
+  DivZeroAnalysis Zero;
+  DataflowOptions Options;
+  // Stream of the statistics and diagnostics printed by analyze().
+  llvm::raw_ostream *Log = &llvm::errs();
+  // Summaries of the callees of the function analyzed, read by the three
+  // analyses at its calls, and of the function itself; none if null.
+  SummaryTable *Summaries = nullptr;
+
+  ProductAnalysis(DataflowOptions Options = DataflowOptions())
+      : Null(Options), Ovf(Options), Zero(Options), Options(Options) {}
+
+  /**
+   * @brief Analyze F and print the findings of the three analyses.
+   */
+  llvm::PreservedAnalyses run(llvm::Function &F, llvm::FunctionAnalysisManager &FAM);
+
+  /**
+   * @brief Number F for the three analyses and query FAM: the part of run()
+   * that uses the analysis manager.
+   */
+  void setup(Function &F, FunctionAnalysisManager &FAM);
+
+  /**
+   * @brief Solve F and check its instructions, after setup().
+   */
+  void analyze(Function &F);
+
+  /**
+   * @brief Print the findings of every analysis on F to Out.
+   */
+  void report(Function &F, raw_ostream &Out);
+
+  /**
+   * @brief Solve F again, after analyze(), with the arguments of Context for
+   * the three analyses, and summarize it for that context.
+   */
+  FunctionSummary analyzeContext(Function &F, const CallContext &Context);
+
+ protected:
+  friend Engine;
+
+  /**
+   * @brief Apply the transfer function of every analysis to its component.
+   *
+   * With call contexts, a call is summarized for the arguments of the three
+   * analyses at once, so its callee is analyzed once per joint context.
+   */
+  void transfer(Instruction *I, const ProductMemory *In, ProductMemory &NOut);
+
+  /**
+   * @brief Set the In Memory of the entry block of every analysis.
+   */
+  void entry(ProductMemory &InMem);
+
+  /**
+   * @brief Refine every component for the edge from block Pred to block B.
+   *
+   * @return false if any analysis proves the edge infeasible.
+   */
+  bool edge(unsigned Pred, unsigned B, ProductMemory &Mem);
+
+  std::string getAnalysisName() {
+    return "Dataflow";
+  }
+
+ private:
+  PointerAnalysisResult *Shared = nullptr;
+  std::unique_ptr<FunctionIndex> Blocks;
+  std::unique_ptr<WeakTopologicalOrder> WTO;
+  std::unique_ptr<Engine> Fixpoint;
+  // Contexts admitted at the calls of the current solve.
+  ContextSlots Slots;
+};
+
+}  // namespace dataflow
+
+#endif  // PRODUCT_ANALYSIS_H
@@ -0,0 +1,65 @@
+#ifndef STEENSGAARD_ANALYSIS_H
+#define STEENSGAARD_ANALYSIS_H
+
+#include "PointerAnalysis.h"
+
+#include <vector>
+
+namespace dataflow {
+
+/**
+ * @brief Unification-based (Steensgaard) pointer analysis.
+ *
+ * Pointers and locations are grouped into classes with union-find, and each
+ * class points to at most one class of locations. A constraint unifies the
+ * classes on both of its sides, so the constraints are solved in a single
+ * pass, in near-linear time, at the cost of precision: two pointers that may
+ * point to a common site point to exactly the same sites.
+ */
+class SteensgaardAnalysis : public PointerAnalysis {
+ public:
+  /**
+   * @brief Unify the constraints of every instruction in function F.
+   *
+   * @param F The function for which pointer analysis is done
+   * @param Index Value numbering of F
+   */
+  SteensgaardAnalysis(Function &F, const ValueIndex &Index);
+
+ protected:
+  SetRef pointsToNode(unsigned N) const override { return sitesPointedBy(N); }
+
+  SetRef contents(unsigned Site) const override {
+    return sitesPointedBy(NumNodes + Site);
+  }
+
+ private:
+  // Union-find over the pointer nodes, then the location of every site,
+  // then the locations created for pointers that point nowhere yet.
+  std::vector<unsigned> Parent;
+  std::vector<unsigned> Rank;
+  // Class pointed to by each representative, or NoNode.
+  std::vector<unsigned> Pointee;
+  // Sites in the class of each representative.
+  std::vector<SetRef> ClassSites;
+
+  unsigned addNode();
+  unsigned find(unsigned N);
+
+  /**
+   * @brief The class pointed to by the class of N, created if N points
+   * nowhere yet.
+   */
+  unsigned pointee(unsigned N);
+
+  /**
+   * @brief Merge the classes of A and B, and then the classes they point to.
+   */
+  void unify(unsigned A, unsigned B);
+
+  SetRef sitesPointedBy(unsigned N) const;
+};
+
+}  // namespace dataflow
+
+#endif  // STEENSGAARD_ANALYSIS_H
@@ -2,6 +2,7 @@
 #define UTILS_H
 
 #include "NullPointerAnalysis.h"
+#include "llvm/ADT/STLFunctionalExtras.h"
 
 extern const char *WHITESPACES;
 
@@ -38,22 +39,25 @@ Domain::Element extractFromValue(const Value *Val);
  * @brief Get the Domain of Val from Memory Or try Extracting it.
  *
  * @param Mem Memory containing the domain of Val.
+ * @param Index Value numbering the keys of Mem.
  * @param Val Value whose domain is to be extracted from Mem.
- * @return Domain* Domain of Val in Mem
+ * @return Domain Domain of Val in Mem
  */
-Domain *getOrExtract(const Memory *Mem, const Value *Val);
+Domain getOrExtract(const Memory *Mem, const ValueIndex &Index, const Value *Val);
 
 /**
- * @brief Print the Memorm Mem in a human readable format to stderr.
+ * @brief Print the Memorm Mem in a human readable format to OS.
  *
  * Format:
  *   [ <variable1> |-> <domain1> ]
  *   [ <variable2> |-> <domain2> ]
  *  ...
  *
+ * @param OS Stream to print to.
  * @param Mem Memory to print
+ * @param Index Value numbering the keys of Mem.
  */
-void printMemory(const Memory *Mem);
+void printMemory(raw_ostream &OS, const Memory *Mem, const ValueIndex &Index);
 
 /**
  * @brief Print the Before and After domains of an instruction
@@ -62,27 +66,36 @@ void printMemory(const Memory *Mem);
  * Format:
  *   <instruction>:    [ <before> --> <after> ]
  *
+ * @param OS Stream to print to.
  * @param Inst The instruction to print the domains for.
  * @param InMem The incoming memory.
  * @param OutMem The outgoing memory.
+ * @param Index Value numbering the keys of InMem and OutMem.
  */
-void printInstructionTransfer(
-    Instruction *Inst, const Memory *InMem, const Memory *OutMem);
+void printInstructionTransfer(raw_ostream &OS,
+    Instruction *Inst,
+    const Memory *InMem,
+    const Memory *OutMem,
+    const ValueIndex &Index);
 
 /**
  * @brief Print the In and Out memory of every instruction in function F to
- * stderr.
+ * OS.
  *
  * This gives the human-readable representaion of the results of dataflow
  * analysis.
  *
- * @param F Function whose dataflow analysis result to print.
- * @param InMap Map of In memory of every instruction in function F.
- * @param OutMap Map of Out memory of every instruction in function F.
+ * @param OS Stream to print to.
+ * @param Graph Instruction numbering of the function to print.
+ * @param InState Returns the In memory of an instruction, by number.
+ * @param OutState Returns the Out memory of an instruction, by number.
+ * @param Index Value numbering of the function.
  */
-void printMap(Function &F,
-    std::map<Instruction *, Memory *> &InMap,
-    std::map<Instruction *, Memory *> &OutMap);
+void printMap(raw_ostream &OS,
+    const FunctionIndex &Graph,
+    function_ref<const Memory &(unsigned)> InState,
+    function_ref<const Memory &(unsigned)> OutState,
+    const ValueIndex &Index);
 
 }  // namespace dataflow
 
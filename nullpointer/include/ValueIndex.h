@@ -0,0 +1,113 @@
+#ifndef VALUE_INDEX_H
+#define VALUE_INDEX_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/IR/Function.h"
+
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Value Numbering
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Compact integer ID of an llvm Value inside one function.
+ */
+using VarId = unsigned;
+
+/**
+ * @brief ValueIndex assigns every llvm Value used by a function a dense
+ * integer ID, once, when the function is first analyzed.
+ *
+ * Arguments are numbered first, then instructions in layout order, then every
+ * other operand (constants, globals). Abstract memories are keyed by these
+ * IDs; variable() is only needed to print them. Values inserted into the
+ * function later get the next IDs, and the IDs of erased values are not
+ * reused.
+ */
+class ValueIndex {
+ public:
+  /**
+   * @brief ID returned by lookup() for values that do not occur in the
+   * function.
+   */
+  static const VarId NoVar = ~0u;
+
+  /**
+   * @brief Number all values of function F.
+   *
+   * @param F The function whose values are numbered.
+   */
+  ValueIndex(Function &F);
+
+  /**
+   * @brief Get the ID of Val, which must occur in the function.
+   *
+   * @param Val The value to get the ID of.
+   * @return VarId The ID of Val.
+   */
+  VarId id(const Value *Val) const;
+
+  /**
+   * @brief Get the ID of Val, or NoVar if Val does not occur in the function.
+   *
+   * @param Val The value to get the ID of.
+   * @return VarId The ID of Val, or NoVar.
+   */
+  VarId lookup(const Value *Val) const;
+
+  /**
+   * @brief Number Val, inserted into the function after it was numbered.
+   *
+   * @param Val The value to number.
+   * @return VarId The ID of Val, a new one unless Val is already numbered.
+   */
+  VarId add(const Value *Val);
+
+  /**
+   * @brief Forget Val, about to be erased from the function.
+   *
+   * @param Val The value to forget.
+   */
+  void remove(const Value *Val);
+
+  /**
+   * @brief Get the value numbered Id.
+   *
+   * @param Id The ID of the value.
+   * @return const Value* The value with ID Id, or null if it was removed.
+   */
+  const Value *value(VarId Id) const { return Values[Id]; }
+
+  /**
+   * @brief Get the printable name of the value numbered Id.
+   *
+   * The name is computed with variable() the first time it is requested and
+   * cached, so dumping many memories formats each value only once.
+   *
+   * @param Id The ID of the value.
+   * @return const std::string& The name of the value.
+   */
+  const std::string &name(VarId Id) const;
+
+  /**
+   * @brief Number of values in the table.
+   */
+  unsigned size() const { return Values.size(); }
+
+ private:
+  DenseMap<const Value *, VarId> Ids;
+  std::vector<const Value *> Values;
+  mutable std::vector<std::string> Names;
+
+  void insert(const Value *Val);
+};
+
+}  // namespace dataflow
+
+#endif  // VALUE_INDEX_H
@@ -0,0 +1,70 @@
+#ifndef WEAK_TOPOLOGICAL_ORDER_H
+#define WEAK_TOPOLOGICAL_ORDER_H
+
+#include "FunctionIndex.h"
+
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Weak Topological Order
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief Bourdoncle's weak topological order of the blocks reachable from the
+ * entry of a function.
+ *
+ * The order is a sequence of blocks and components. A component is a head
+ * block followed by the weak topological order of the rest of a strongly
+ * connected subgraph. Every edge goes forward in the sequence, except edges
+ * from a component to its own head. The heads are therefore a set of
+ * widening points that cuts every cycle.
+ *
+ * The order is stored flat: position I holds a block, and if that block is a
+ * head, its component spans positions [I, componentEnd(I)).
+ */
+class WeakTopologicalOrder {
+ public:
+  /**
+   * @brief Compute the order of the blocks of Graph.
+   *
+   * @param Graph The block graph of the function.
+   */
+  WeakTopologicalOrder(const FunctionIndex &Graph);
+
+  /**
+   * @brief Number of positions, i.e. of blocks reachable from the entry.
+   */
+  unsigned size() const { return Order.size(); }
+
+  /**
+   * @brief Get the block at position I.
+   */
+  unsigned block(unsigned I) const { return Order[I]; }
+
+  /**
+   * @brief Is the block at position I the head of a component?
+   */
+  bool isHead(unsigned I) const { return Heads[I]; }
+
+  /**
+   * @brief Get one past the last position of the component headed at I.
+   */
+  unsigned componentEnd(unsigned I) const { return End[I]; }
+
+  /**
+   * @brief Is block B the head of a component?
+   */
+  bool isHeadBlock(unsigned B) const { return HeadBlocks[B]; }
+
+ private:
+  std::vector<unsigned> Order;
+  std::vector<bool> Heads;
+  std::vector<unsigned> End;
+  std::vector<bool> HeadBlocks;
+};
+
+}  // namespace dataflow
+
+#endif  // WEAK_TOPOLOGICAL_ORDER_H
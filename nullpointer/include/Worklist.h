@@ -0,0 +1,74 @@
+#ifndef WORKLIST_H
+#define WORKLIST_H
+
+#include "FunctionIndex.h"
+#include "llvm/ADT/BitVector.h"
+
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Block Worklist
+//===----------------------------------------------------------------------===//
+
+/**
+ * @brief A set of blocks waiting to be evaluated, popped in reverse
+ * post-order.
+ *
+ * For a forward analysis this evaluates a block after its (non back-edge)
+ * predecessors, so facts reach it before it is first visited. Membership is a
+ * bit per block, and the pending blocks are kept in a min-heap of their
+ * reverse post-order indices.
+ */
+class Worklist {
+ public:
+  /**
+   * @brief Make an empty worklist for the blocks of Graph.
+   */
+  explicit Worklist(const FunctionIndex &Graph)
+      : Graph(Graph), Queued(Graph.blocks()) {}
+
+  bool empty() const { return Heap.empty(); }
+
+  /**
+   * @brief Add block B, unless it is already in the worklist.
+   */
+  void insert(unsigned B) {
+    unsigned I = Graph.rpoIndex(B);
+    if (Queued.test(I))
+      return;
+    Queued.set(I);
+    Heap.push(I);
+  }
+
+  /**
+   * @brief Add every block of the function.
+   */
+  void insertAll() {
+    for (unsigned B = 0; B < Graph.blocks(); ++B)
+      insert(B);
+  }
+
+  /**
+   * @brief Remove and return the pending block that comes first in reverse
+   * post-order.
+   */
+  unsigned pop() {
+    unsigned I = Heap.top();
+    Heap.pop();
+    Queued.reset(I);
+    return Graph.rpoBlock(I);
+  }
+
+ private:
+  const FunctionIndex &Graph;
+  BitVector Queued;
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>> Heap;
+};
+
+}  // namespace dataflow
+
+#endif  // WORKLIST_H
@@ -0,0 +1,297 @@
+#include "AndersenAnalysis.h"
+
+#include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/Support/ThreadPool.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+namespace dataflow {
+
+void AndersenAnalysis::push(unsigned N) {
+  if (Queued.test(N))
+    return;
+  Queued.set(N);
+  Pending.push_back(N);
+}
+
+unsigned AndersenAnalysis::find(unsigned N) {
+  while (Nodes[N].Rep != N) {
+    Nodes[N].Rep = Nodes[Nodes[N].Rep].Rep;
+    N = Nodes[N].Rep;
+  }
+  return N;
+}
+
+void AndersenAnalysis::addEdge(unsigned From, unsigned To) {
+  From = find(From);
+  To = find(To);
+  if (From == To || !Edges.insert({From, To}).second)
+    return;
+  Nodes[From].Copies.push_back(To);
+  if (flowInto(To, Nodes[From].Pts))
+    push(To);
+}
+
+bool AndersenAnalysis::flowInto(unsigned N, SetRef Pts) {
+  SetRef Old = Nodes[N].Pts;
+  Nodes[N].Pts = Cache.unite(Old, Pts);
+  return Nodes[N].Pts != Old;
+}
+
+void AndersenAnalysis::merge(unsigned Into, unsigned From) {
+  Node &A = Nodes[Into];
+  Node &B = Nodes[From];
+  B.Rep = Into;
+  A.Pts = Cache.unite(A.Pts, B.Pts);
+  // Only the sites propagated along the edges of both nodes are done.
+  A.Done = Cache.intersect(A.Done, B.Done);
+  A.Resolved = Cache.intersect(A.Resolved, B.Resolved);
+  A.Copies.insert(A.Copies.end(), B.Copies.begin(), B.Copies.end());
+  A.Loads.insert(A.Loads.end(), B.Loads.begin(), B.Loads.end());
+  A.Stores.insert(A.Stores.end(), B.Stores.begin(), B.Stores.end());
+  B = Node{Into, Cache.empty(), Cache.empty(), Cache.empty(), {}, {}, {}};
+  push(Into);
+}
+
+bool AndersenAnalysis::collapseCycles(
+    unsigned Root, DenseMap<unsigned, unsigned> &DFN, std::vector<unsigned> *Order) {
+  // Tarjan's algorithm over the copy edges; a node whose component is
+  // complete gets UINT_MAX, so it no longer lowers the others.
+  std::vector<unsigned> Stack;
+  bool Merged = false;
+
+  std::function<unsigned(unsigned)> Visit = [&](unsigned V) -> unsigned {
+    Stack.push_back(V);
+    unsigned Low = DFN.size() + 1;
+    DFN[V] = Low;
+    for (size_t I = 0; I < Nodes[V].Copies.size(); ++I) {
+      unsigned W = find(Nodes[V].Copies[I]);
+      if (W == V)
+        continue;
+      auto It = DFN.find(W);
+      Low = std::min(Low, It == DFN.end() ? Visit(W) : It->second);
+    }
+    if (Low == DFN[V]) {
+      unsigned Top;
+      do {
+        Top = Stack.back();
+        Stack.pop_back();
+        DFN[Top] = UINT_MAX;
+        if (Top != V) {
+          merge(V, Top);
+          Merged = true;
+        }
+      } while (Top != V);
+      if (Order)
+        Order->push_back(V);
+    }
+    return Low;
+  };
+  Visit(find(Root));
+  return Merged;
+}
+
+void AndersenAnalysis::solve() {
+  for (unsigned N = 0; N < Nodes.size(); ++N) {
+    if (Nodes[N].Pts != Cache.empty())
+      push(N);
+  }
+
+  while (!Pending.empty()) {
+    unsigned N = Pending.front();
+    Pending.pop_front();
+    Queued.reset(N);
+    N = find(N);
+
+    // Difference propagation: only the sites added since the last visit.
+    Node &Cur = Nodes[N];
+    SetRef Delta = Cache.subtract(Cur.Pts, Cur.Done);
+    if (Delta == Cache.empty())
+      continue;
+
+    for (unsigned Site : *Delta) {
+      unsigned C = contentsNode(Site);
+      for (size_t I = 0; I < Cur.Loads.size(); ++I)
+        addEdge(C, Cur.Loads[I]);
+      for (size_t I = 0; I < Cur.Stores.size(); ++I)
+        addEdge(Cur.Stores[I], C);
+    }
+
+    bool Collapsed = false;
+    for (size_t I = 0; I < Cur.Copies.size(); ++I) {
+      unsigned To = find(Cur.Copies[I]);
+      if (To == N)
+        continue;
+      if (flowInto(To, Delta))
+        push(To);
+      // Lazy cycle detection: equal sets on both ends of an edge hint at a
+      // cycle through it, which is searched for once per edge.
+      if (Nodes[To].Pts == Cur.Pts && Checked.insert({N, To}).second) {
+        DenseMap<unsigned, unsigned> DFN;
+        if (collapseCycles(To, DFN)) {
+          Collapsed = true;
+          break;
+        }
+      }
+    }
+
+    // After a collapse, Delta is left out of Done so that the node N was
+    // merged into propagates it along all of its edges.
+    if (Collapsed)
+      push(find(N));
+    else
+      Cur.Done = Cache.unite(Cur.Done, Delta);
+  }
+
+  for (unsigned N = 0; N < Nodes.size(); ++N)
+    Nodes[N].Rep = find(N);
+}
+
+void AndersenAnalysis::solveInParallel(unsigned Threads) {
+  ThreadPool Pool(hardware_concurrency(Threads));
+  // Run Body(I) for I in [0, Count), in a few chunks per thread.
+  auto ParallelFor = [&](size_t Count, function_ref<void(size_t)> Body) {
+    size_t Chunk = std::max<size_t>(1, Count / (4 * Threads));
+    for (size_t Begin = 0; Begin < Count; Begin += Chunk) {
+      size_t End = std::min(Count, Begin + Chunk);
+      Pool.async([=] {
+        for (size_t I = Begin; I < End; ++I)
+          Body(I);
+      });
+    }
+    Pool.wait();
+  };
+
+  bool Changed = true;
+  while (Changed) {
+    // Collapse every cycle; Tarjan's algorithm completes the components in
+    // reverse topological order.
+    DenseMap<unsigned, unsigned> DFN;
+    std::vector<unsigned> Order;
+    for (unsigned N = 0; N < Nodes.size(); ++N) {
+      if (find(N) == N && !DFN.count(N))
+        collapseCycles(N, DFN, &Order);
+    }
+    std::reverse(Order.begin(), Order.end());
+    for (unsigned N = 0; N < Nodes.size(); ++N)
+      Nodes[N].Rep = find(N);
+
+    // Group the nodes in waves: every predecessor of a node is in an earlier
+    // wave, so the nodes of a wave can pull from their predecessors at once.
+    std::vector<unsigned> Wave(Nodes.size(), 0);
+    std::vector<std::vector<unsigned>> Preds(Nodes.size());
+    std::vector<std::vector<unsigned>> Waves;
+    for (unsigned N : Order) {
+      if (Wave[N] == Waves.size())
+        Waves.emplace_back();
+      Waves[Wave[N]].push_back(N);
+      for (unsigned Succ : Nodes[N].Copies) {
+        Succ = Nodes[Succ].Rep;
+        if (Succ == N)
+          continue;
+        Preds[Succ].push_back(N);
+        Wave[Succ] = std::max(Wave[Succ], Wave[N] + 1);
+      }
+    }
+
+    // Propagate the new part of every set along the copy edges.
+    std::vector<SetRef> Delta(Nodes.size(), Cache.empty());
+    for (const std::vector<unsigned> &Members : Waves) {
+      ParallelFor(Members.size(), [&](size_t I) {
+        unsigned N = Members[I];
+        Node &Cur = Nodes[N];
+        for (unsigned Pred : Preds[N])
+          Cur.Pts = Cache.unite(Cur.Pts, Delta[Pred]);
+        Delta[N] = Cache.subtract(Cur.Pts, Cur.Done);
+        Cur.Done = Cur.Pts;
+      });
+    }
+
+    // Each node lists the edges that its load and store constraints add for
+    // its new sites.
+    std::vector<std::vector<std::pair<unsigned, unsigned>>> NewEdges(Order.size());
+    ParallelFor(Order.size(), [&](size_t I) {
+      Node &Cur = Nodes[Order[I]];
+      if (Cur.Loads.empty() && Cur.Stores.empty())
+        return;
+      SetRef New = Cache.subtract(Cur.Pts, Cur.Resolved);
+      Cur.Resolved = Cur.Pts;
+      for (unsigned Site : *New) {
+        unsigned C = Nodes[contentsNode(Site)].Rep;
+        for (unsigned L : Cur.Loads)
+          NewEdges[I].push_back({C, Nodes[L].Rep});
+        for (unsigned R : Cur.Stores)
+          NewEdges[I].push_back({Nodes[R].Rep, C});
+      }
+    });
+
+    // Add the edges in a fixed order, then flow the whole set of the source
+    // of each new edge into its target.
+    std::vector<std::vector<unsigned>> Sources(Nodes.size());
+    std::vector<unsigned> Targets;
+    for (const auto &List : NewEdges) {
+      for (auto Edge : List) {
+        if (Edge.first == Edge.second || !Edges.insert(Edge).second)
+          continue;
+        Nodes[Edge.first].Copies.push_back(Edge.second);
+        if (Sources[Edge.second].empty())
+          Targets.push_back(Edge.second);
+        Sources[Edge.second].push_back(Edge.first);
+      }
+    }
+    std::vector<SetRef> Incoming(Targets.size(), Cache.empty());
+    ParallelFor(Targets.size(), [&](size_t I) {
+      for (unsigned Source : Sources[Targets[I]])
+        Incoming[I] = Cache.unite(Incoming[I], Nodes[Source].Pts);
+    });
+    std::vector<char> Grew(Targets.size(), false);
+    ParallelFor(Targets.size(), [&](size_t I) {
+      Grew[I] = flowInto(Targets[I], Incoming[I]);
+    });
+    Changed = std::find(Grew.begin(), Grew.end(), true) != Grew.end();
+  }
+
+  Pending.clear();
+  for (unsigned N = 0; N < Nodes.size(); ++N)
+    Nodes[N].Rep = find(N);
+}
+
+AndersenAnalysis::AndersenAnalysis(Function &F, const ValueIndex &Index, unsigned Threads)
+    : PointerAnalysis(Index) {
+  std::vector<Constraint> Constraints = collectConstraints(F);
+  Nodes.resize(NumNodes);
+  std::vector<PointsToSet> AddressOf(NumNodes);
+  for (const Constraint &C : Constraints) {
+    switch (C.Kind) {
+    case Constraint::AddressOf:
+      AddressOf[C.Dst].set(C.Src);
+      break;
+    case Constraint::Load:
+      Nodes[C.Src].Loads.push_back(C.Dst);
+      break;
+    case Constraint::Store:
+      Nodes[C.Dst].Stores.push_back(C.Src);
+      break;
+    }
+  }
+
+  // One more node for the contents of each allocation site.
+  Nodes.resize(NumNodes + Sites.size());
+  for (unsigned N = 0; N < Nodes.size(); ++N) {
+    Nodes[N].Rep = N;
+    Nodes[N].Pts = N < NumNodes ? Cache.intern(AddressOf[N]) : Cache.empty();
+    Nodes[N].Done = Cache.empty();
+    Nodes[N].Resolved = Cache.empty();
+  }
+  Queued.resize(Nodes.size());
+
+  if (Threads > 1)
+    solveInParallel(Threads);
+  else
+    solve();
+  finish();
+}
+
+}  // namespace dataflow
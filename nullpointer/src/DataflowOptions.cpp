@@ -0,0 +1,90 @@
+#include "DataflowOptions.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <tuple>
+
+using namespace llvm;
+
+namespace dataflow {
+
+StringRef pointerModeName(PointerMode Mode) {
+  switch (Mode) {
+  case PointerMode::Andersen:
+    return "andersen";
+  case PointerMode::Steensgaard:
+    return "steensgaard";
+  case PointerMode::FlowSensitive:
+    return "flow-sensitive";
+  case PointerMode::Auto:
+    return "auto";
+  }
+  return "";
+}
+
+bool parsePassName(StringRef Name, StringRef Pass, DataflowOptions &Options) {
+  if (!Name.consume_front(Pass))
+    return false;
+  if (Name.empty())
+    return true;
+  if (!Name.consume_front("<") || !Name.consume_back(">"))
+    return false;
+
+  SmallVector<StringRef, 4> Params;
+  Name.split(Params, ';', -1, false);
+  for (StringRef Param : Params) {
+    StringRef Value;
+    std::tie(Param, Value) = Param.split('=');
+
+    // getAsInteger() returns true on error.
+    bool Valid = false;
+    if (Param == "stats") {
+      Options.Stats = true;
+      Valid = Value.empty();
+    } else if (Param == "print-pointers") {
+      Options.PrintPointers = true;
+      Valid = Value.empty();
+    } else if (Param == "widen-delay") {
+      Valid = !Value.getAsInteger(10, Options.WidenDelay);
+    } else if (Param == "narrow") {
+      Valid = !Value.getAsInteger(10, Options.NarrowIterations);
+    } else if (Param == "pointers") {
+      for (PointerMode Mode : {PointerMode::Andersen, PointerMode::Steensgaard,
+               PointerMode::FlowSensitive, PointerMode::Auto}) {
+        if (Value == pointerModeName(Mode)) {
+          Options.Pointers = Mode;
+          Valid = true;
+        }
+      }
+    } else if (Param == "steensgaard-insts") {
+      Valid = !Value.getAsInteger(10, Options.SteensgaardInsts);
+    } else if (Param == "steensgaard-pointers") {
+      Valid = !Value.getAsInteger(10, Options.SteensgaardPointers);
+    } else if (Param == "pointer-threads") {
+      Valid = !Value.getAsInteger(10, Options.PointerThreads) && Options.PointerThreads > 0;
+    } else if (Param == "threads") {
+      Valid = !Value.getAsInteger(10, Options.Threads) && Options.Threads > 0;
+    } else if (Param == "summaries") {
+      Options.Summaries = true;
+      Valid = Value.empty();
+    } else if (Param == "contexts") {
+      Valid = !Value.getAsInteger(10, Options.Contexts);
+      Options.Summaries |= Options.Contexts > 0;
+    } else if (Param == "compare-pointers") {
+      Options.ComparePointers = true;
+      Valid = Value.empty();
+    } else if (Param == "time-edits") {
+      Options.TimeEdits = true;
+      Valid = Value.empty();
+    }
+
+    if (!Valid) {
+      errs() << "Invalid " << Pass << " option: " << Param << "\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace dataflow
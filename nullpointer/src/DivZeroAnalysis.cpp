@@ -1,5 +1,6 @@
 #include "DivZeroAnalysis.h"
 
+#include "ParallelDriver.h"
 #include "Utils.h"
 
 namespace dataflow {
@@ -12,26 +13,125 @@ namespace dataflow {
  * PART 1
  * 1. Implement "check" that checks if a given instruction is erroneous or not.
  * 2. Implement "transfer" that computes the semantics of each instruction.
- *    This means that you have to complete "eval" function, too.
  *
  * PART 2
- * 1. Implement "doAnalysis" that stores your results in "InMap" and "OutMap".
- * 2. Implement "flowIn" that joins the memory set of all incoming flows.
- * 3. Implement "flowOut" that flows the memory set to all outgoing flows.
- * 4. Implement "join" to union two Memory objects, accounting for Domain value.
- * 5. Implement "equal" to compare two Memory objects.
+ * The fixpoint is computed by DataflowEngine, by chaotic iteration over the
+ * blocks, with the join and equality of DomainLattice.
  */
 
-bool DivZeroAnalysis::check(Instruction *Inst) {
-  /**
-   * TODO: Write your code to check if Inst can cause a division by zero.
-   *
-   * Inst can cause a division by zero if:
-   *   Inst is a signed or unsigned division instruction and,
-   *   The divisor is either Zero or MaybeZero.
-   *
-   * Hint: getOrExtract function may be useful to simplify your code.
-   */
+/**
+ * @brief Get the Domain of the integer Val in Mem: constants are Zero or
+ * NonZero, and a variable missing from Mem is Uninit.
+ */
+static Domain getOrExtractZero(const Memory *Mem, const ValueIndex &Index, const Value *Val) {
+  if (auto *CI = dyn_cast<ConstantInt>(Val))
+    return Domain(CI->isZero() ? Domain::Zero : Domain::NonZero);
+  if (const Domain *Dom = Mem->find(Index.lookup(Val)))
+    return *Dom;
+  return Domain(Domain::Uninit);
+}
+
+void DivZeroAnalysis::transfer(Instruction *Inst, const Memory *In, Memory &NOut) {
+  if (!Inst->getType()->isIntegerTy())
+    return;
+
+  auto Get = [&](const Value *Val) { return getOrExtractZero(In, *Index, Val); };
+  Domain Result(Domain::MaybeZero);
+  if (auto *BinOp = dyn_cast<BinaryOperator>(Inst)) {
+    Domain L = Get(BinOp->getOperand(0));
+    Domain R = Get(BinOp->getOperand(1));
+    switch (BinOp->getOpcode()) {
+    case Instruction::Add:
+      Result = Domain::add(L, R);
+      break;
+    case Instruction::Sub:
+      Result = Domain::sub(L, R);
+      break;
+    case Instruction::Mul:
+      Result = Domain::mul(L, R);
+      break;
+    case Instruction::SDiv:
+    case Instruction::UDiv:
+      Result = Domain::div(L, R);
+      break;
+    default:
+      // Other operators are not modeled: their result is any value.
+      break;
+    }
+  } else if (auto *Phi = dyn_cast<PHINode>(Inst)) {
+    // Values from paths that have not been evaluated yet are Uninit.
+    Result = Domain(Domain::Uninit);
+    for (Value *Incoming : Phi->incoming_values())
+      Result = Domain::join(Result, Get(Incoming));
+  } else if (auto *Cast = dyn_cast<CastInst>(Inst)) {
+    // Integer casts keep zero and nonzero values apart, except truncations.
+    if (isa<ZExtInst>(Cast) || isa<SExtInst>(Cast))
+      Result = Get(Cast->getOperand(0));
+  } else if (auto *Call = dyn_cast<CallInst>(Inst)) {
+    // A call returns what the summary of its callee says.
+    if (const FunctionSummary *Summary = callSummary(Call, In)) {
+      applySummary(Call, *Summary, In, NOut);
+      return;
+    }
+  }
+  // Loads, other calls, comparisons and the rest can be any value.
+  NOut.set(Index->id(Inst), Result);
+}
+
+void DivZeroAnalysis::entry(Memory &InMem) {
+  for (Argument &Arg : Graph->basicBlock(0)->getParent()->args()) {
+    // Assume arguments can be any value, so they are MaybeZero, unless a
+    // call context gives them.
+    if (!Arg.getType()->isIntegerTy())
+      continue;
+    if (EntryContext && !EntryContext->Zero.empty())
+      InMem.set(Index->id(&Arg), EntryContext->Zero[Arg.getArgNo()]);
+    else
+      InMem.set(Index->id(&Arg), Domain(Domain::MaybeZero));
+  }
+}
+
+bool DivZeroAnalysis::edge(unsigned Pred, unsigned B, Memory &Mem) {
+  // Only a conditional branch on x == 0 or x != 0 refines the memory of its
+  // edges.
+  auto *Branch = dyn_cast<BranchInst>(Graph->basicBlock(Pred)->getTerminator());
+  if (!Branch || !Branch->isConditional() ||
+      Branch->getSuccessor(0) == Branch->getSuccessor(1))
+    return true;
+  auto *Cmp = dyn_cast<ICmpInst>(Branch->getCondition());
+  if (!Cmp || !Cmp->isEquality())
+    return true;
+
+  Value *Val = Cmp->getOperand(0);
+  Value *Other = Cmp->getOperand(1);
+  if (isa<ConstantInt>(Val))
+    std::swap(Val, Other);
+  auto *Zero = dyn_cast<ConstantInt>(Other);
+  if (!Zero || !Zero->isZero() || isa<Constant>(Val))
+    return true;
+
+  // The true edge of x == 0 and the false edge of x != 0 have x Zero.
+  bool TrueEdge = Branch->getSuccessor(0) == Graph->basicBlock(B);
+  bool IsZero = TrueEdge == (Cmp->getPredicate() == CmpInst::ICMP_EQ);
+  Domain Required(IsZero ? Domain::Zero : Domain::NonZero);
+  VarId Name = Index->id(Val);
+  if (const Domain *Current = Mem.find(Name)) {
+    // A value already known to be the other one cannot take this edge.
+    if ((Domain::equal(*Current, Domain::Zero) ||
+         Domain::equal(*Current, Domain::NonZero)) &&
+        !Domain::equal(*Current, Required))
+      return false;
+  }
+  Mem.set(Name, Required);
+  return true;
+}
+
+void DivZeroAnalysis::doAnalysis(Function &F) {
+  Fixpoint->solve(ChaoticIteration<>());
+}
+
+bool DivZeroAnalysis::check(Instruction *Inst, function_ref<const Memory &(unsigned)> InState) {
+  // A signed or unsigned division whose divisor is Zero or MaybeZero.
   if (!(isa<BinaryOperator>(Inst) &&
         (Inst->getOpcode() == Instruction::SDiv ||
          Inst->getOpcode() == Instruction::UDiv))) {
@@ -39,42 +139,127 @@ bool DivZeroAnalysis::check(Instruction *Inst) {
   }
 
   Value *Divisor = Inst->getOperand(1);
-  Domain *DivisorDomain = getOrExtract(InMap[Inst], Divisor);
+  Domain DivisorDomain = getOrExtractZero(&InState(Graph->number(Inst)), *Index, Divisor);
 
-  return (Domain::equal(*DivisorDomain, Domain::Zero) || Domain::equal(*DivisorDomain, Domain::MaybeZero));
+  return (Domain::equal(DivisorDomain, Domain::Zero) || Domain::equal(DivisorDomain, Domain::MaybeZero));
 }
 
-PreservedAnalyses DivZeroAnalysis::run(Function &F, FunctionAnalysisManager &) {
-  outs() << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+void DivZeroAnalysis::summarize(Function &F,
+    function_ref<const Memory &(unsigned)> InState, FunctionSummary &Summary) {
+  Summary.Zero = Domain(Domain::Uninit);
+  if (!F.getReturnType()->isIntegerTy())
+    return;
+  for (Instruction &I : instructions(F)) {
+    auto *Return = dyn_cast<ReturnInst>(&I);
+    if (Return && Reached(Graph->block(Graph->number(Return)))) {
+      Summary.Zero = Domain::join(Summary.Zero,
+          getOrExtractZero(&InState(Graph->number(Return)), *Index, Return->getReturnValue()));
+    }
+  }
+}
 
-  // Initializing InMap and OutMap.
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
-    auto Inst = &(*Iter);
-    InMap[Inst] = new Memory;
-    OutMap[Inst] = new Memory;
+const FunctionSummary *DivZeroAnalysis::callSummary(CallInst *Call, const Memory *In) {
+  if (!Summaries)
+    return nullptr;
+  if (!Options.Contexts)
+    return Summaries->lookup(*Call);
+  CallContext Context;
+  addArguments(Call, In, Context);
+  return Summaries->lookup(*Call, Context, Slots);
+}
+
+void DivZeroAnalysis::addArguments(CallInst *Call, const Memory *In, CallContext &Context) {
+  for (Value *Arg : Call->args()) {
+    // An argument the caller knows nothing of is MaybeZero, as on entry.
+    Domain Dom(Domain::MaybeZero);
+    if (Arg->getType()->isIntegerTy() &&
+        !Domain::equal(getOrExtractZero(In, *Index, Arg), Domain::Uninit))
+      Dom = getOrExtractZero(In, *Index, Arg);
+    Context.Zero.push_back(Dom);
   }
+}
+
+void DivZeroAnalysis::applySummary(CallInst *Call, const FunctionSummary &Summary,
+    const Memory *In, Memory &NOut) {
+  if (Call->getType()->isIntegerTy())
+    NOut.set(Index->id(Call), Summary.Zero);
+}
+
+FunctionSummary DivZeroAnalysis::analyzeContext(Function &F, const CallContext &Context) {
+  EntryContext = &Context;
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, DomainLattice(), *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
+  doAnalysis(F);
+
+  FunctionSummary Summary;
+  summarize(F, [this](unsigned N) -> const Memory & { return Fixpoint->inState(N); }, Summary);
+
+  Fixpoint.reset();
+  EntryContext = nullptr;
+  return Summary;
+}
+
+PreservedAnalyses DivZeroAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+  setup(F, FAM);
+  analyze(F);
+  report(F, outs());
+  return PreservedAnalyses::all();
+}
+
+void DivZeroAnalysis::setup(Function &F, FunctionAnalysisManager &) {
+  // Number the values, instructions and blocks of F once; memories are keyed
+  // by value IDs and stored by block number.
+  Values = std::make_unique<ValueIndex>(F);
+  Blocks = std::make_unique<FunctionIndex>(F);
+  Index = Values.get();
+  Graph = Blocks.get();
+}
+
+void DivZeroAnalysis::analyze(Function &F) {
+  ErrorInsts.clear();
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, DomainLattice(), *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
 
   // The chaotic iteration algorithm is implemented inside doAnalysis().
   doAnalysis(F);
 
   // Check each instruction in function F for potential divide-by-zero error.
+  auto InState = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N); };
   for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
     auto Inst = &(*Iter);
-    if (check(Inst))
+    if (check(Inst, InState))
       ErrorInsts.insert(Inst);
   }
 
-  printMap(F, InMap, OutMap);
-  outs() << "Potential Instructions by " << getAnalysisName() << ": \n";
-  for (auto Inst : ErrorInsts) {
-    outs() << *Inst << "\n";
+  if (Summaries)
+    summarize(F, InState, Summaries->summary(F));
+
+  printMap(*Log, *Graph, InState,
+      [this](unsigned N) -> const Memory & { return Fixpoint->outState(N); },
+      *Index);
+  if (Options.Stats) {
+    *Log << getAnalysisName() << " stats for " << F.getName() << ": "
+         << Fixpoint->blockVisits() << " block visits, " << Fixpoint->instVisits()
+         << " instruction visits (" << Graph->blocks() << " blocks, "
+         << Graph->size() << " instructions)\n";
   }
 
-  for (auto Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
-    delete InMap[&(*Iter)];
-    delete OutMap[&(*Iter)];
+  Fixpoint.reset();
+}
+
+void DivZeroAnalysis::report(Function &F, raw_ostream &Out) {
+  if (Options.Stats && Options.Contexts) {
+    *Log << getAnalysisName() << " contexts for " << F.getName() << ": ";
+    Summaries->printContexts(*Log, F);
+    *Log << "\n";
+  }
+  Out << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  Out << "Potential Instructions by " << getAnalysisName() << ": \n";
+  for (auto Inst : ErrorInsts) {
+    Out << *Inst << "\n";
   }
-  return PreservedAnalyses::all();
 }
 
 extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo llvmGetPassPluginInfo() {
@@ -83,8 +268,9 @@ extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo llvmGetPassPluginIn
                 [](StringRef Name,
                     ModulePassManager &MPM,
                     ArrayRef<PassBuilder::PipelineElement>) {
-                  if (Name == "DivZero") {
-                    MPM.addPass(createModuleToFunctionPassAdaptor(DivZeroAnalysis()));
+                  DataflowOptions Options;
+                  if (parsePassName(Name, "DivZero", Options)) {
+                    MPM.addPass(ParallelDriver<DivZeroAnalysis>(Options));
                     return true;
                   }
                   return false;
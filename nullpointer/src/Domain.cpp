@@ -13,28 +13,61 @@ Domain::Domain(Element V) {
   Value = V;
 }
 
-Domain *Domain::join(Domain *E1, Domain *E2) {
-  if (E1->Value == Uninit) return new Domain(*E2);
-  if (E2->Value == Uninit) return new Domain(*E1);
-  
-  if (E1->Value == MaybeNull || E2->Value == MaybeNull)
-    return new Domain(MaybeNull);
+/**
+ * @brief Is V an element of the divide-by-zero analysis?
+ */
+static bool isZeroElement(Domain::Element V) {
+  return V == Domain::Zero || V == Domain::NonZero || V == Domain::MaybeZero;
+}
+
+Domain Domain::add(Domain E1, Domain E2) {
+  if (E1.Value == Uninit || E2.Value == Uninit) return Domain(Uninit);
+  if (E1.Value == Zero) return E2;
+  if (E2.Value == Zero) return E1;
+  // NonZero + NonZero can cancel out.
+  return Domain(MaybeZero);
+}
+
+Domain Domain::sub(Domain E1, Domain E2) {
+  // x - y is zero exactly when x + (-y) is, and -y is zero exactly when y is.
+  return add(E1, E2);
+}
+
+Domain Domain::mul(Domain E1, Domain E2) {
+  if (E1.Value == Uninit || E2.Value == Uninit) return Domain(Uninit);
+  if (E1.Value == Zero || E2.Value == Zero) return Domain(Zero);
+  if (E1.Value == NonZero && E2.Value == NonZero) return Domain(NonZero);
+  return Domain(MaybeZero);
+}
+
+Domain Domain::div(Domain E1, Domain E2) {
+  // Dividing by zero has no result.
+  if (E1.Value == Uninit || E2.Value == Uninit || E2.Value == Zero)
+    return Domain(Uninit);
+  if (E1.Value == Zero) return Domain(Zero);
+  // Integer division rounds toward zero, so NonZero / NonZero may be zero.
+  return Domain(MaybeZero);
+}
+
+Domain Domain::join(Domain E1, Domain E2) {
+  if (E1.Value == Uninit) return E2;
+  if (E2.Value == Uninit) return E1;
 
-  if (E1->Value == Null && E2->Value == Null)
-    return new Domain(Null);
+  if (E1.Value == E2.Value)
+    return E1;
 
-  if (E1->Value == NonNull && E2->Value == NonNull)
-    return new Domain(NonNull);
+  if (isZeroElement(E1.Value) && isZeroElement(E2.Value))
+    return Domain(MaybeZero);
 
-  // One is Null, the other is NonNull
-  return new Domain(MaybeNull);
+  // One is Null, the other is NonNull, or either is MaybeNull
+  return Domain(MaybeNull);
 }
 
 bool Domain::equal(Domain E1, Domain E2) {
   return E1.Value == E2.Value;
 }
 
-void Domain::print(raw_ostream &O) {
+void Domain::print(raw_ostream &O) const {
   switch (Value) {
     case Uninit:
       O << "Uninit         ";
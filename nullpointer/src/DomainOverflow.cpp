@@ -1,6 +1,7 @@
 #include "DomainOverflow.h"
 
 #include <algorithm>
+#include <iterator>
 
 using namespace llvm;
 
@@ -152,6 +153,54 @@ DomainOverflow DomainOverflow::widen(const DomainOverflow &Old,
   return DomainOverflow(l, h);
 }
 
+DomainOverflow DomainOverflow::widenWithThresholds(
+    const DomainOverflow &Old, const DomainOverflow &New,
+    const std::vector<long long> &Thresholds) {
+  if (Old.isBottom) return New;
+  if (New.isBottom) return Old;
+
+  // A bound that grows moves to the closest threshold that still contains
+  // it; past the last threshold it jumps to infinity like widen.
+  long long l = Old.low;
+  if (New.low < Old.low) {
+    auto It = std::upper_bound(Thresholds.begin(), Thresholds.end(), New.low);
+    l = It == Thresholds.begin() ? NEG_INF : *std::prev(It);
+  }
+
+  long long h = Old.high;
+  if (New.high > Old.high) {
+    auto It = std::lower_bound(Thresholds.begin(), Thresholds.end(), New.high);
+    h = It == Thresholds.end() ? POS_INF : *It;
+  }
+
+  return DomainOverflow(l, h);
+}
+
+DomainOverflow DomainOverflow::narrow(const DomainOverflow &Old,
+                                      const DomainOverflow &New) {
+  // Narrowing operator: only refines the bounds that widening sent to
+  // infinity, so a descending sequence stays finite
+
+  if (Old.isBottom || New.isBottom) return New;
+
+  long long l = (Old.low == NEG_INF) ? New.low : Old.low;
+  long long h = (Old.high == POS_INF) ? New.high : Old.high;
+
+  return DomainOverflow(l, h);
+}
+
+DomainOverflow DomainOverflow::meet(const DomainOverflow &A,
+                                    const DomainOverflow &B) {
+  if (A.isBottom || B.isBottom)
+    return bottom();
+
+  long long l = std::max(A.low,  B.low);
+  long long h = std::min(A.high, B.high);
+  if (l > h)
+    return bottom();
+  return DomainOverflow(l, h);
+}
+
 bool DomainOverflow::equal(const DomainOverflow &A,
                            const DomainOverflow &B) {
   if (A.isBottom != B.isBottom)
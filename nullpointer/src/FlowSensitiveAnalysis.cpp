@@ -0,0 +1,275 @@
+#include "FlowSensitiveAnalysis.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/IteratedDominanceFrontier.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+
+#include <functional>
+#include <queue>
+#include <utility>
+
+namespace dataflow {
+
+const unsigned FlowSensitiveAnalysis::Initial;
+
+void FlowSensitiveAnalysis::buildMemorySSA(
+    Function &F, const DenseMap<const Instruction *, SetRef> &Accessed) {
+  DominatorTree DT(F);
+
+  // Blocks storing to each site; their iterated dominance frontier is where
+  // the versions of the site meet.
+  std::vector<SmallPtrSet<BasicBlock *, 8>> DefBlocks(Sites.size());
+  for (const auto &Access : Accessed) {
+    if (isa<StoreInst>(Access.first)) {
+      for (unsigned Site : *Access.second)
+        DefBlocks[Site].insert(const_cast<BasicBlock *>(Access.first->getParent()));
+    }
+  }
+  DenseMap<const BasicBlock *, std::vector<unsigned>> Phis;
+  ForwardIDFCalculator IDF(DT);
+  for (unsigned Site = 0; Site < Sites.size(); ++Site) {
+    if (DefBlocks[Site].empty())
+      continue;
+    SmallVector<BasicBlock *, 8> PhiBlocks;
+    IDF.setDefiningBlocks(DefBlocks[Site]);
+    IDF.calculate(PhiBlocks);
+    for (BasicBlock *Block : PhiBlocks) {
+      Phis[Block].push_back(Defs.size());
+      Defs.push_back({Site, NoNode, NoNode, {}});
+    }
+  }
+
+  // Nodes are ranked by the position of their instruction in reverse
+  // post-order, the phis of a block first.
+  DenseMap<const BasicBlock *, unsigned> BlockRank;
+  unsigned Position = 0;
+  for (BasicBlock *Block : ReversePostOrderTraversal<Function *>(&F)) {
+    BlockRank[Block] = Position;
+    Position += Block->size() + 1;
+  }
+  Rank.assign(NumNodes, ~0u);
+  std::vector<unsigned> DefRank(Defs.size(), 0);
+  for (const auto &Block : Phis) {
+    for (unsigned Def : Block.second)
+      DefRank[Def] = BlockRank[Block.first];
+  }
+
+  // Rename along the dominator tree: Current holds the version of every site
+  // reaching the instruction visited, and Undo the versions to restore when
+  // the walk leaves a block.
+  std::vector<unsigned> Current(Sites.size(), Initial);
+  std::vector<std::pair<unsigned, unsigned>> Undo;
+  std::vector<std::pair<DomTreeNode *, size_t>> Stack = {{DT.getRootNode(), 0}};
+  while (!Stack.empty()) {
+    DomTreeNode *Node = Stack.back().first;
+    size_t &Mark = Stack.back().second;
+    if (Mark != 0) {
+      // All children are done.
+      for (size_t I = Undo.size(); I > Mark - 1; --I)
+        Current[Undo[I - 1].first] = Undo[I - 1].second;
+      Undo.resize(Mark - 1);
+      Stack.pop_back();
+      continue;
+    }
+    Mark = Undo.size() + 1;
+
+    BasicBlock *Block = Node->getBlock();
+    auto Define = [&](unsigned Site, unsigned Def) {
+      Undo.push_back({Site, Current[Site]});
+      Current[Site] = Def;
+    };
+    auto It = Phis.find(Block);
+    if (It != Phis.end()) {
+      for (unsigned Def : It->second)
+        Define(Defs[Def].Site, Def);
+    }
+
+    unsigned Position = BlockRank[Block];
+    for (Instruction &I : *Block) {
+      ++Position;
+      unsigned N = NodeOf[Index.id(&I)];
+      if (N != NoNode)
+        Rank[N] = Position;
+      auto Access = Accessed.find(&I);
+      if (Access == Accessed.end())
+        continue;
+      if (StoreInst *Store = dyn_cast<StoreInst>(&I)) {
+        unsigned Ptr = NodeOf[Index.id(Store->getPointerOperand())];
+        unsigned Val = NodeOf[Index.id(Store->getValueOperand())];
+        for (unsigned Site : *Access->second) {
+          Defs.push_back({Site, Ptr, Val, {Current[Site]}});
+          DefRank.push_back(Position);
+          Define(Site, Defs.size() - 1);
+        }
+      } else {
+        MemoryUse &Use = Uses[N];
+        Use.Ptr = NodeOf[Index.id(cast<LoadInst>(&I)->getPointerOperand())];
+        for (unsigned Site : *Access->second)
+          Use.Reads.push_back({Site, Current[Site]});
+      }
+    }
+
+    for (BasicBlock *Succ : successors(Block)) {
+      auto Succs = Phis.find(Succ);
+      if (Succs == Phis.end())
+        continue;
+      for (unsigned Def : Succs->second)
+        Defs[Def].Prev.push_back(Current[Defs[Def].Site]);
+    }
+
+    for (DomTreeNode *Child : *Node)
+      Stack.push_back({Child, 0});
+  }
+  Rank.insert(Rank.end(), DefRank.begin(), DefRank.end());
+}
+
+PointerAnalysis::SetRef FlowSensitiveAnalysis::evaluate(unsigned N) {
+  SetRef Result = Pts[N];
+  if (N < NumNodes) {
+    // A load reads the versions of the sites its pointer points to.
+    auto It = Uses.find(N);
+    if (It == Uses.end())
+      return Result;
+    SetRef Ptr = Pts[It->second.Ptr];
+    for (const auto &Read : It->second.Reads) {
+      if (Ptr->test(Read.first))
+        Result = Cache.unite(Result, Pts[versionNode(Read.second)]);
+    }
+    return Result;
+  }
+
+  const MemoryDef &Def = Defs[N - NumNodes];
+  if (Def.Ptr == NoNode) {
+    for (unsigned Prev : Def.Prev)
+      Result = Cache.unite(Result, Pts[versionNode(Prev)]);
+    return Result;
+  }
+  SetRef Ptr = Pts[Def.Ptr];
+  SetRef Old = Pts[versionNode(Def.Prev[0])];
+  if (!Ptr->test(Def.Site))
+    return Cache.unite(Result, Old);
+  SetRef Val = Def.Val == NoNode ? Cache.empty() : Pts[Def.Val];
+  if (Singular.test(Def.Site) && Ptr->count() == 1)
+    return Cache.unite(Result, Val);
+  return Cache.unite(Cache.unite(Result, Old), Val);
+}
+
+void FlowSensitiveAnalysis::solve() {
+  // Sets only grow, so a strong update decided while the pointer of the
+  // store still points to fewer sites stays sound, and visiting nodes in
+  // reverse post-order settles most pointers before their stores.
+  using Entry = std::pair<unsigned, unsigned>;
+  std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> Heap;
+  BitVector Queued(Pts.size(), true);
+  for (unsigned N = 0; N < Pts.size(); ++N)
+    Heap.push({Rank[N], N});
+
+  while (!Heap.empty()) {
+    unsigned N = Heap.top().second;
+    Heap.pop();
+    Queued.reset(N);
+    SetRef New = evaluate(N);
+    if (New == Pts[N])
+      continue;
+    Pts[N] = New;
+    for (unsigned User : Users[N]) {
+      if (!Queued.test(User)) {
+        Queued.set(User);
+        Heap.push({Rank[User], User});
+      }
+    }
+  }
+}
+
+FlowSensitiveAnalysis::FlowSensitiveAnalysis(
+    Function &F, const ValueIndex &Index, const PointerAnalysis &Insensitive)
+    : PointerAnalysis(Index) {
+  collectConstraints(F);
+
+  // Loads merged by the offline reduction may read different versions, so
+  // every pointer gets a node of its own.
+  NumNodes = 0;
+  for (VarId Var = 0; Var < Index.size(); ++Var) {
+    if (NodeOf[Var] != NoNode)
+      NodeOf[Var] = NumNodes++;
+  }
+
+  // Sites each load and store may access, by the flow-insensitive result.
+  DenseMap<VarId, unsigned> SiteOf;
+  for (unsigned Site = 0; Site < Sites.size(); ++Site)
+    SiteOf[Sites[Site]] = Site;
+  DenseMap<const std::vector<VarId> *, SetRef> Rows;
+  auto SitesOf = [&](Value *Ptr) {
+    const std::vector<VarId> &Row = Insensitive.aliasedAllocas(Index.id(Ptr));
+    auto It = Rows.insert({&Row, Cache.empty()});
+    if (It.second) {
+      PointsToSet Set;
+      for (VarId Alloca : Row)
+        Set.set(SiteOf[Alloca]);
+      It.first->second = Cache.intern(Set);
+    }
+    return It.first->second;
+  };
+  DenseMap<const Instruction *, SetRef> Accessed;
+  for (Instruction &I : instructions(F)) {
+    SetRef Set = Cache.empty();
+    if (StoreInst *Store = dyn_cast<StoreInst>(&I)) {
+      if (Store->getValueOperand()->getType()->isPointerTy())
+        Set = SitesOf(Store->getPointerOperand());
+    } else if (LoadInst *Load = dyn_cast<LoadInst>(&I)) {
+      if (NodeOf[Index.id(Load)] != NoNode)
+        Set = SitesOf(Load->getPointerOperand());
+    }
+    if (Set != Cache.empty())
+      Accessed[&I] = Set;
+  }
+
+  // A static alloca is a single object, so a store to it alone overwrites it.
+  // So is the last object of a dynamic one when its address does not escape.
+  Singular.resize(Sites.size());
+  for (unsigned Site = 0; Site < Sites.size(); ++Site) {
+    if (cast<AllocaInst>(Index.value(Sites[Site]))->isStaticAlloca() || !escapes(Sites[Site]))
+      Singular.set(Site);
+  }
+
+  Defs.push_back({~0u, NoNode, NoNode, {}});
+  buildMemorySSA(F, Accessed);
+
+  Pts.assign(NumNodes + Defs.size(), Cache.empty());
+  for (unsigned Site = 0; Site < Sites.size(); ++Site) {
+    PointsToSet Set;
+    Set.set(Site);
+    Pts[NodeOf[Sites[Site]]] = Cache.intern(Set);
+  }
+
+  Users.resize(Pts.size());
+  auto AddUser = [&](unsigned N, unsigned User) {
+    if (N != NoNode && N != versionNode(Initial))
+      Users[N].push_back(User);
+  };
+  for (unsigned Def = Initial + 1; Def < Defs.size(); ++Def) {
+    AddUser(Defs[Def].Ptr, versionNode(Def));
+    AddUser(Defs[Def].Val, versionNode(Def));
+    for (unsigned Prev : Defs[Def].Prev)
+      AddUser(versionNode(Prev), versionNode(Def));
+  }
+  for (const auto &Use : Uses) {
+    AddUser(Use.second.Ptr, Use.first);
+    for (const auto &Read : Use.second.Reads)
+      AddUser(versionNode(Read.second), Use.first);
+  }
+
+  solve();
+
+  Contents.assign(Sites.size(), Cache.empty());
+  for (unsigned Def = Initial + 1; Def < Defs.size(); ++Def)
+    Contents[Defs[Def].Site] = Cache.unite(Contents[Defs[Def].Site], Pts[versionNode(Def)]);
+
+  finish();
+}
+
+}  // namespace dataflow
@@ -0,0 +1,81 @@
+#include "FunctionIndex.h"
+
+#include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/InstIterator.h"
+
+#include <cassert>
+
+namespace dataflow {
+
+FunctionIndex::FunctionIndex(Function &F) {
+  DenseMap<const BasicBlock *, unsigned> BlockNumbers;
+  for (BasicBlock &Block : F) {
+    BlockNumbers[&Block] = Blocks.size();
+    Blocks.push_back(&Block);
+    InstBegin.push_back(Insts.size());
+    for (Instruction &I : Block) {
+      Numbers[&I] = Insts.size();
+      Insts.push_back(&I);
+      BlockOf.push_back(Blocks.size() - 1);
+    }
+  }
+  InstBegin.push_back(Insts.size());
+
+  PredBegin.reserve(Insts.size() + 1);
+  SuccBegin.reserve(Insts.size() + 1);
+  for (Instruction *I : Insts) {
+    BasicBlock *Block = I->getParent();
+    unsigned N = Numbers[I];
+
+    PredBegin.push_back(Preds.size());
+    if (I != &Block->front()) {
+      Preds.push_back(N - 1);
+    } else {
+      for (BasicBlock *Pred : llvm::predecessors(Block))
+        Preds.push_back(Numbers[Pred->getTerminator()]);
+    }
+
+    SuccBegin.push_back(Succs.size());
+    if (I != Block->getTerminator()) {
+      Succs.push_back(N + 1);
+    } else {
+      for (BasicBlock *Succ : llvm::successors(Block))
+        Succs.push_back(Numbers[&Succ->front()]);
+    }
+  }
+  PredBegin.push_back(Preds.size());
+  SuccBegin.push_back(Succs.size());
+
+  for (BasicBlock *Block : Blocks) {
+    BlockPredBegin.push_back(BlockPreds.size());
+    for (BasicBlock *Pred : llvm::predecessors(Block))
+      BlockPreds.push_back(BlockNumbers[Pred]);
+    BlockSuccBegin.push_back(BlockSuccs.size());
+    for (BasicBlock *Succ : llvm::successors(Block))
+      BlockSuccs.push_back(BlockNumbers[Succ]);
+  }
+  BlockPredBegin.push_back(BlockPreds.size());
+  BlockSuccBegin.push_back(BlockSuccs.size());
+
+  const unsigned Unvisited = ~0u;
+  RPOIndex.assign(Blocks.size(), Unvisited);
+  for (BasicBlock *Block : ReversePostOrderTraversal<Function *>(&F)) {
+    RPOIndex[BlockNumbers[Block]] = RPOBlocks.size();
+    RPOBlocks.push_back(BlockNumbers[Block]);
+  }
+  for (unsigned B = 0; B < Blocks.size(); ++B) {
+    if (RPOIndex[B] == Unvisited) {
+      RPOIndex[B] = RPOBlocks.size();
+      RPOBlocks.push_back(B);
+    }
+  }
+}
+
+unsigned FunctionIndex::number(const Instruction *Inst) const {
+  auto It = Numbers.find(Inst);
+  assert(It != Numbers.end() && "instruction does not belong to the function");
+  return It->second;
+}
+
+}  // namespace dataflow
@@ -0,0 +1,124 @@
+#include "FunctionSummary.h"
+
+#include "llvm/ADT/SCCIterator.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace dataflow {
+
+std::vector<long long> CallContext::key() const {
+  std::vector<long long> Key = {(long long)Null.size(), (long long)Zero.size(),
+      (long long)Ranges.size()};
+  for (Domain Dom : Null)
+    Key.push_back(Dom.Value);
+  for (Domain Dom : Zero)
+    Key.push_back(Dom.Value);
+  for (const overflow::DomainOverflow &Range : Ranges) {
+    Key.push_back(Range.isBottom);
+    Key.push_back(Range.low);
+    Key.push_back(Range.high);
+  }
+  return Key;
+}
+
+SummaryTable::SummaryTable(CallGraph &CG, unsigned MaxContexts) : MaxContexts(MaxContexts) {
+  // scc_iterator visits the components in post-order, so the callees of a
+  // component out of it already have a level.
+  unsigned Component = 0;
+  for (scc_iterator<CallGraph *> It = scc_begin(&CG); !It.isAtEnd(); ++It, ++Component) {
+    std::vector<Function *> Members;
+    for (CallGraphNode *Node : *It) {
+      Function *F = Node->getFunction();
+      if (F && !F->isDeclaration())
+        Members.push_back(F);
+    }
+    if (Members.empty())
+      continue;
+
+    unsigned Level = 0;
+    for (CallGraphNode *Node : *It) {
+      for (const CallGraphNode::CallRecord &Call : *Node) {
+        auto Callee = Entries.find(Call.second->getFunction());
+        if (Callee != Entries.end())
+          Level = std::max(Level, Callee->second.Level + 1);
+      }
+    }
+
+    // The members are entered last, so that calls inside the component do
+    // not count above.
+    for (Function *F : Members)
+      Entries[F] = {Component, Level, FunctionSummary(), std::make_unique<ContextTable>()};
+    if (Levels.size() <= Level)
+      Levels.resize(Level + 1);
+    Levels[Level].insert(Levels[Level].end(), Members.begin(), Members.end());
+  }
+}
+
+const FunctionSummary *SummaryTable::lookup(const CallBase &Call) const {
+  auto CalleeEntry = Entries.find(Call.getCalledFunction());
+  if (CalleeEntry == Entries.end())
+    return nullptr;
+  auto CallerEntry = Entries.find(Call.getFunction());
+  assert(CallerEntry != Entries.end() && "Caller is not in the module");
+  if (CallerEntry->second.Component == CalleeEntry->second.Component)
+    return nullptr;
+  return &CalleeEntry->second.Summary;
+}
+
+const FunctionSummary *SummaryTable::lookup(
+    const CallBase &Call, const CallContext &Context, ContextSlots &Slots) const {
+  const FunctionSummary *Summary = lookup(Call);
+  if (!Summary)
+    return nullptr;
+
+  // The slots belong to the solve of the caller, on this thread.
+  std::vector<long long> Key = Context.key();
+  std::map<std::vector<long long>, bool> &Seen = Slots[&Call];
+  auto Slot = Seen.find(Key);
+  bool First = Slot == Seen.end();
+  if (First) {
+    unsigned Admitted = std::count_if(Seen.begin(), Seen.end(),
+        [](const std::pair<const std::vector<long long>, bool> &S) { return S.second; });
+    Slot = Seen.emplace(Key, Admitted < MaxContexts).first;
+  }
+
+  ContextTable &Contexts = *Entries.find(Call.getCalledFunction())->second.Contexts;
+  std::lock_guard<std::mutex> Guard(Contexts.Lock);
+  if (!Slot->second || !Contexts.Analyzer) {
+    Contexts.OverLimit += First;
+    return Summary;
+  }
+  Contexts.Admitted += First;
+  auto Found = Contexts.Summaries.find(Key);
+  if (Found != Contexts.Summaries.end())
+    return &Found->second;
+  // The nodes of a std::map stay in place, so the summary can be read
+  // after the lock is released while other contexts are added.
+  FunctionSummary Analyzed = Contexts.Analyzer(Context);
+  return &Contexts.Summaries.emplace(std::move(Key), std::move(Analyzed)).first->second;
+}
+
+void SummaryTable::setAnalyzer(const Function &F,
+    std::function<FunctionSummary(const CallContext &)> Analyzer) {
+  auto Found = Entries.find(&F);
+  assert(Found != Entries.end() && "Function is not defined in the module");
+  Found->second.Contexts->Analyzer = std::move(Analyzer);
+}
+
+void SummaryTable::printContexts(raw_ostream &OS, const Function &F) const {
+  auto Found = Entries.find(&F);
+  assert(Found != Entries.end() && "Function is not defined in the module");
+  const ContextTable &Contexts = *Found->second.Contexts;
+  OS << Contexts.Summaries.size() << " analyzed, "
+     << Contexts.Admitted - Contexts.Summaries.size() << " reused, "
+     << Contexts.OverLimit << " over the limit";
+}
+
+FunctionSummary &SummaryTable::summary(const Function &F) {
+  auto Found = Entries.find(&F);
+  assert(Found != Entries.end() && "Function is not defined in the module");
+  return Found->second.Summary;
+}
+
+}  // namespace dataflow
@@ -0,0 +1,366 @@
+#include "IncrementalAnalysis.h"
+
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+namespace dataflow {
+
+unsigned IncrementalAnalysis::addNode(unsigned Ptr) {
+  Graph.push_back({Ptr, Cache.empty(), Cache.empty(), Cache.empty(), {}, {}, {}, {}});
+  Queued.resize(Graph.size());
+  return Graph.size() - 1;
+}
+
+void IncrementalAnalysis::grow() {
+  NodeOf.resize(Index.size(), NoNode);
+  Constrained.resize(Index.size());
+  Dereferenced.resize(Index.size());
+  Escaping.resize(Index.size());
+  while (PointerNode.size() < NumNodes)
+    PointerNode.push_back(addNode(PointerNode.size()));
+  while (SiteNode.size() < Sites.size())
+    SiteNode.push_back(addNode(NoNode));
+}
+
+void IncrementalAnalysis::push(unsigned N) {
+  if (Queued.test(N))
+    return;
+  Queued.set(N);
+  Pending.push_back(N);
+}
+
+bool IncrementalAnalysis::flowInto(unsigned N, SetRef Pts) {
+  SetRef Old = Graph[N].Pts;
+  Graph[N].Pts = Cache.unite(Old, Pts);
+  if (Graph[N].Pts == Old)
+    return false;
+  if (Graph[N].Ptr != NoNode)
+    Changed.insert(Graph[N].Ptr);
+  return true;
+}
+
+void IncrementalAnalysis::link(unsigned From, unsigned To) {
+  if (Support[{From, To}]++ != 0)
+    return;
+  Graph[From].Succs.push_back(To);
+  Graph[To].Preds.push_back(From);
+  if (flowInto(To, Graph[From].Pts))
+    push(To);
+}
+
+void IncrementalAnalysis::unlink(unsigned From, unsigned To) {
+  auto It = Support.find({From, To});
+  if (--It->second != 0)
+    return;
+  Support.erase(It);
+  auto Drop = [](std::vector<unsigned> &List, unsigned N) {
+    *std::find(List.begin(), List.end(), N) = List.back();
+    List.pop_back();
+  };
+  Drop(Graph[From].Succs, To);
+  Drop(Graph[To].Preds, From);
+}
+
+void IncrementalAnalysis::resolve(unsigned N, SetRef Sites, bool Add) {
+  // Every edge joins a pointer node and the contents of a site.
+  for (unsigned Site : *Sites) {
+    unsigned C = SiteNode[Site];
+    for (size_t I = 0; I < Graph[N].Loads.size(); ++I)
+      Add ? link(C, Graph[N].Loads[I]) : unlink(C, Graph[N].Loads[I]);
+    for (size_t I = 0; I < Graph[N].Stores.size(); ++I)
+      Add ? link(Graph[N].Stores[I], C) : unlink(Graph[N].Stores[I], C);
+  }
+}
+
+void IncrementalAnalysis::apply(const Constraint &C, bool Add, std::vector<Loss> &Seeds) {
+  auto Drop = [](std::vector<unsigned> &List, unsigned N) {
+    List.erase(std::find(List.begin(), List.end(), N));
+  };
+
+  switch (C.Kind) {
+  case Constraint::AddressOf: {
+    unsigned N = PointerNode[C.Dst];
+    if (Add) {
+      PointsToSet Site;
+      Site.set(C.Src);
+      Graph[N].Base = Cache.intern(Site);
+      if (flowInto(N, Graph[N].Base))
+        push(N);
+    } else {
+      Seeds.push_back({N, Graph[N].Base});
+      Graph[N].Base = Cache.empty();
+    }
+    break;
+  }
+  case Constraint::Load: {
+    unsigned L = PointerNode[C.Dst];
+    unsigned P = PointerNode[C.Src];
+    if (Add) {
+      Graph[P].Loads.push_back(L);
+      for (unsigned Site : *Graph[P].Resolved)
+        link(SiteNode[Site], L);
+      break;
+    }
+    Drop(Graph[P].Loads, L);
+    for (unsigned Site : *Graph[P].Resolved) {
+      unlink(SiteNode[Site], L);
+      Seeds.push_back({L, Graph[SiteNode[Site]].Pts});
+    }
+    break;
+  }
+  case Constraint::Store: {
+    unsigned P = PointerNode[C.Dst];
+    unsigned R = PointerNode[C.Src];
+    if (Add) {
+      Graph[P].Stores.push_back(R);
+      for (unsigned Site : *Graph[P].Resolved)
+        link(R, SiteNode[Site]);
+      break;
+    }
+    Drop(Graph[P].Stores, R);
+    for (unsigned Site : *Graph[P].Resolved) {
+      unlink(R, SiteNode[Site]);
+      Seeds.push_back({SiteNode[Site], Graph[R].Pts});
+    }
+    break;
+  }
+  }
+}
+
+void IncrementalAnalysis::solve() {
+  while (!Pending.empty()) {
+    // Components of the copy edges reachable from the pending nodes, by
+    // Tarjan's algorithm, which completes them in reverse topological order.
+    // A node whose component is complete gets UINT_MAX.
+    DenseMap<unsigned, unsigned> DFN;
+    std::vector<unsigned> Stack;
+    std::vector<std::vector<unsigned>> Components;
+    std::function<unsigned(unsigned)> Visit = [&](unsigned V) -> unsigned {
+      Stack.push_back(V);
+      unsigned Low = DFN.size() + 1;
+      DFN[V] = Low;
+      for (unsigned W : Graph[V].Succs) {
+        auto It = DFN.find(W);
+        Low = std::min(Low, It == DFN.end() ? Visit(W) : It->second);
+      }
+      if (Low == DFN[V]) {
+        Components.emplace_back();
+        unsigned Top;
+        do {
+          Top = Stack.back();
+          Stack.pop_back();
+          DFN[Top] = UINT_MAX;
+          Components.back().push_back(Top);
+        } while (Top != V);
+      }
+      return Low;
+    };
+    for (unsigned N : Pending) {
+      if (!DFN.count(N))
+        Visit(N);
+    }
+    Pending.clear();
+    Queued.reset();
+
+    // Every node of a cycle ends with the same set, so a component takes the
+    // union of its members and passes it on, in topological order.
+    for (auto It = Components.rbegin(); It != Components.rend(); ++It) {
+      SetRef Pts = Cache.empty();
+      for (unsigned N : *It)
+        Pts = Cache.unite(Pts, Graph[N].Pts);
+      for (unsigned N : *It) {
+        flowInto(N, Pts);
+        for (unsigned Succ : Graph[N].Succs)
+          flowInto(Succ, Pts);
+      }
+    }
+
+    // The new sites add the edges of the loads and stores, whose targets are
+    // solved again in the next round.
+    for (const std::vector<unsigned> &Members : Components) {
+      for (unsigned N : Members) {
+        SetRef New = Cache.subtract(Graph[N].Pts, Graph[N].Resolved);
+        if (New == Cache.empty())
+          continue;
+        Graph[N].Resolved = Graph[N].Pts;
+        resolve(N, New, true);
+      }
+    }
+  }
+}
+
+void IncrementalAnalysis::rederive(const std::vector<Loss> &Seeds) {
+  // Delete and rederive. First every site that may have been derived from a
+  // lost one is taken out: a site reaches a node from its base, from a
+  // predecessor, or along the edges of the loads and stores through a node
+  // that has the site.
+  DenseMap<unsigned, SetRef> Lost;
+  std::vector<unsigned> Order;
+  std::vector<Loss> Stack;
+  auto Lose = [&](unsigned N, SetRef Sites) {
+    auto It = Lost.insert({N, Cache.empty()});
+    if (It.second)
+      Order.push_back(N);
+    SetRef New = Cache.subtract(Cache.intersect(Sites, Graph[N].Pts), It.first->second);
+    if (New == Cache.empty())
+      return;
+    It.first->second = Cache.unite(It.first->second, New);
+    Stack.push_back({N, New});
+  };
+  for (const Loss &Seed : Seeds)
+    Lose(Seed.first, Seed.second);
+  size_t Visits = 0;
+  while (!Stack.empty()) {
+    // When most of the graph depends on the lost sites, as in large cycles,
+    // solving again is cheaper than taking the sites out one by one.
+    if (++Visits > Graph.size()) {
+      restart();
+      return;
+    }
+    Loss Cur = Stack.back();
+    Stack.pop_back();
+    unsigned N = Cur.first;
+    for (unsigned Succ : Graph[N].Succs)
+      Lose(Succ, Cur.second);
+    for (unsigned Site : *Cache.intersect(Cur.second, Graph[N].Resolved)) {
+      unsigned C = SiteNode[Site];
+      for (unsigned L : Graph[N].Loads)
+        Lose(L, Graph[C].Pts);
+      for (unsigned R : Graph[N].Stores)
+        Lose(C, Graph[R].Pts);
+    }
+  }
+
+  // The edges added for the lost sites go, and come back with the sites.
+  for (unsigned N : Order) {
+    SetRef Sites = Lost[N];
+    if (Sites == Cache.empty())
+      continue;
+    resolve(N, Cache.intersect(Sites, Graph[N].Resolved), false);
+    Graph[N].Resolved = Cache.subtract(Graph[N].Resolved, Sites);
+    Graph[N].Pts = Cache.subtract(Graph[N].Pts, Sites);
+    if (Graph[N].Ptr != NoNode)
+      Changed.insert(Graph[N].Ptr);
+  }
+
+  // Then the sites still derivable come back from the bases and the
+  // predecessors, and propagate as usual.
+  for (unsigned N : Order) {
+    if (Lost[N] == Cache.empty())
+      continue;
+    flowInto(N, Graph[N].Base);
+    for (unsigned Pred : Graph[N].Preds)
+      flowInto(N, Graph[Pred].Pts);
+    push(N);
+  }
+  solve();
+}
+
+void IncrementalAnalysis::restart() {
+  // Every copy edge comes from a load or store constraint and a site, so
+  // the bases are all that is left.
+  Support.clear();
+  for (unsigned N = 0; N < Graph.size(); ++N) {
+    Node &Cur = Graph[N];
+    Cur.Succs.clear();
+    Cur.Preds.clear();
+    Cur.Pts = Cur.Base;
+    Cur.Resolved = Cache.empty();
+    if (Cur.Ptr != NoNode)
+      Changed.insert(Cur.Ptr);
+    if (Cur.Pts != Cache.empty())
+      push(N);
+  }
+  solve();
+}
+
+void IncrementalAnalysis::updateEscapes(Instruction *I, const Instruction *Erased) {
+  for (Value *Op : I->operands()) {
+    AllocaInst *Alloca = dyn_cast<AllocaInst>(Op);
+    VarId Var = Alloca ? Index.lookup(Alloca) : ValueIndex::NoVar;
+    if (Var != ValueIndex::NoVar)
+      Escaping[Var] = addressEscapes(Alloca, Erased);
+  }
+}
+
+void IncrementalAnalysis::insert(Instruction *I) {
+  for (Use &U : I->operands()) {
+    if (!isa<BasicBlock>(U.get()))
+      Values.add(U.get());
+  }
+  Values.add(I);
+  grow();
+
+  Constraint C;
+  if (constraintOf(*I, C)) {
+    grow();
+    if (C.Dst != NoNode && C.Src != NoNode) {
+      Owned[I] = C;
+      std::vector<Loss> Seeds;
+      if (Count[key(C)]++ == 0)
+        apply(C, true, Seeds);
+    }
+  }
+  updateEscapes(I, nullptr);
+
+  solve();
+  finish(Changed.getArrayRef());
+  Changed.clear();
+}
+
+void IncrementalAnalysis::erase(Instruction *I) {
+  std::vector<Loss> Seeds;
+  auto It = Owned.find(I);
+  if (It != Owned.end()) {
+    auto Users = Count.find(key(It->second));
+    if (--Users->second == 0) {
+      Count.erase(Users);
+      apply(It->second, false, Seeds);
+    }
+    Owned.erase(It);
+  }
+  updateEscapes(I, I);
+
+  VarId Var = Index.lookup(I);
+  if (Var != ValueIndex::NoVar) {
+    NodeOf[Var] = NoNode;
+    Constrained.reset(Var);
+    Dereferenced.reset(Var);
+    Escaping.reset(Var);
+  }
+  Values.remove(I);
+
+  if (!Seeds.empty())
+    rederive(Seeds);
+  finish(Changed.getArrayRef());
+  Changed.clear();
+}
+
+IncrementalAnalysis::IncrementalAnalysis(Function &F, ValueIndex &Index)
+    : PointerAnalysis(Index), Values(Index) {
+  // Identical constraints are kept once, with the number of instructions
+  // that have them, instead of being dropped.
+  NodeOf.assign(Index.size(), NoNode);
+  std::vector<Loss> Seeds;
+  for (Instruction &I : instructions(F)) {
+    Constraint C;
+    if (!constraintOf(I, C))
+      continue;
+    grow();
+    if (C.Dst == NoNode || C.Src == NoNode)
+      continue;
+    Owned[&I] = C;
+    if (Count[key(C)]++ == 0)
+      apply(C, true, Seeds);
+  }
+
+  solve();
+  Changed.clear();
+  finish();
+}
+
+}  // namespace dataflow
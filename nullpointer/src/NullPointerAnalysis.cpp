@@ -1,6 +1,12 @@
 #include "NullPointerAnalysis.h"
 
+#include "AndersenAnalysis.h"
+#include "IncrementalAnalysis.h"
+#include "ParallelDriver.h"
 #include "Utils.h"
+#include "llvm/Support/Format.h"
+
+#include <chrono>
 #include <iostream>
 
 namespace dataflow {
@@ -10,7 +16,22 @@ namespace dataflow {
 //===----------------------------------------------------------------------===//
 
 
-bool NullPointerAnalysis::check(Instruction *Inst) {
+bool NullPointerAnalysis::check(
+    Instruction *Inst, function_ref<const Memory &(unsigned)> InState) {
+
+  // Can Ptr be null when Inst uses it?
+  auto MayBeNull = [&](Value *Ptr) {
+    // Pointers to stack are safe
+    if (isa<AllocaInst>(Ptr->stripPointerCasts()))
+      return false;
+
+    // Retrieve the domain of the pointer
+    Domain PtrDomain = getOrExtract(&InState(Graph->number(Inst)), *Index, Ptr);
+
+    // Error if the pointer is Null or MaybeNull
+    return (Domain::equal(PtrDomain, Domain::Null) ||
+            Domain::equal(PtrDomain, Domain::MaybeNull));
+  };
 
   Value *Ptr = nullptr;
 
@@ -20,65 +41,326 @@ bool NullPointerAnalysis::check(Instruction *Inst) {
     Ptr = Store->getPointerOperand();
   } else if (auto GEP = dyn_cast<GetElementPtrInst>(Inst)) {
     Ptr = GEP->getPointerOperand();
+  } else if (auto Call = dyn_cast<CallInst>(Inst)) {
+    // A call dereferences the arguments that its callee dereferences.
+    const FunctionSummary *Summary = Summaries ? Summaries->lookup(*Call) : nullptr;
+    if (!Summary) return false;
+    for (unsigned I = 0; I < Summary->Dereferenced.size(); ++I) {
+      if (Summary->Dereferenced[I] && MayBeNull(Call->getArgOperand(I)))
+        return true;
+    }
+    return false;
   }
 
   if (!Ptr) return false;
 
-  // Pointers to stack are safe
-  if (isa<AllocaInst>(Ptr->stripPointerCasts())) {
-      return false;
+  return MayBeNull(Ptr);
+}
+
+/**
+ * @brief Get the position of the argument that Ptr holds, or -1.
+ *
+ * Ptr holds an argument if it is one, or if it is loaded from a local that
+ * only ever stores that argument, as unoptimized code spills arguments.
+ */
+static int argumentOf(Value *Ptr) {
+  Ptr = Ptr->stripPointerCasts();
+  if (auto *Arg = dyn_cast<Argument>(Ptr))
+    return Arg->getArgNo();
+
+  auto *Load = dyn_cast<LoadInst>(Ptr);
+  auto *Slot = Load ? dyn_cast<AllocaInst>(Load->getPointerOperand()) : nullptr;
+  if (!Slot)
+    return -1;
+  Argument *Stored = nullptr;
+  for (User *U : Slot->users()) {
+    if (isa<LoadInst>(U))
+      continue;
+    auto *Store = dyn_cast<StoreInst>(U);
+    if (!Store || Store->getPointerOperand() != Slot)
+      return -1;
+    auto *Arg = dyn_cast<Argument>(Store->getValueOperand());
+    if (!Arg || (Stored && Stored != Arg))
+      return -1;
+    Stored = Arg;
   }
+  return Stored ? (int)Stored->getArgNo() : -1;
+}
 
-  // Retrieve the domain of the pointer
-  Domain *PtrDomain = getOrExtract(InMap[Inst], Ptr);
+void NullPointerAnalysis::summarize(Function &F,
+    function_ref<const Memory &(unsigned)> InState,
+    const SetVector<Instruction *> &Flagged, FunctionSummary &Summary) {
+  Summary.Null = Domain(Domain::Uninit);
+  if (F.getReturnType()->isPointerTy()) {
+    for (Instruction &I : instructions(F)) {
+      auto *Return = dyn_cast<ReturnInst>(&I);
+      if (!Return || !Reached(Graph->block(Graph->number(Return))))
+        continue;
+      Value *Val = Return->getReturnValue();
+      Domain Returned = isa<AllocaInst>(Val->stripPointerCasts())
+          ? Domain(Domain::NonNull)
+          : getOrExtract(&InState(Graph->number(Return)), *Index, Val);
+      Summary.Null = Domain::join(Summary.Null, Returned);
+    }
+  }
 
-  // Error if the pointer is Null or MaybeNull
-  return (Domain::equal(*PtrDomain, Domain::Null) || 
-          Domain::equal(*PtrDomain, Domain::MaybeNull));
+  // The arguments are MaybeNull on entry, so check() flags every
+  // dereference of one that is not tested first.
+  Summary.Dereferenced.assign(F.arg_size(), false);
+  auto Dereference = [&](Value *Ptr) {
+    int Arg = argumentOf(Ptr);
+    if (Arg >= 0)
+      Summary.Dereferenced[Arg] = true;
+  };
+  for (Instruction *Inst : Flagged) {
+    if (auto Load = dyn_cast<LoadInst>(Inst)) {
+      Dereference(Load->getPointerOperand());
+    } else if (auto Store = dyn_cast<StoreInst>(Inst)) {
+      Dereference(Store->getPointerOperand());
+    } else if (auto GEP = dyn_cast<GetElementPtrInst>(Inst)) {
+      Dereference(GEP->getPointerOperand());
+    } else if (auto Call = dyn_cast<CallInst>(Inst)) {
+      const FunctionSummary *Callee = Summaries->lookup(*Call);
+      for (unsigned I = 0; I < Callee->Dereferenced.size(); ++I) {
+        if (Callee->Dereferenced[I])
+          Dereference(Call->getArgOperand(I));
+      }
+    }
+  }
 }
 
-PreservedAnalyses NullPointerAnalysis::run(Function &F, FunctionAnalysisManager &) {
-  outs() << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+const FunctionSummary *NullPointerAnalysis::callSummary(CallInst *Call, const Memory *In) {
+  if (!Summaries)
+    return nullptr;
+  if (!Options.Contexts)
+    return Summaries->lookup(*Call);
+  CallContext Context;
+  addArguments(Call, In, Context);
+  return Summaries->lookup(*Call, Context, Slots);
+}
 
-  // Initializing InMap and OutMap.
-  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
-    auto Inst = &(*Iter);
-    InMap[Inst] = new Memory;
-    OutMap[Inst] = new Memory;
+void NullPointerAnalysis::addArguments(CallInst *Call, const Memory *In, CallContext &Context) {
+  for (Value *Arg : Call->args()) {
+    // An argument the caller knows nothing of is MaybeNull, as on entry.
+    Domain Dom(Domain::MaybeNull);
+    if (isa<AllocaInst>(Arg->stripPointerCasts()))
+      Dom = Domain(Domain::NonNull);
+    else if (Arg->getType()->isPointerTy() &&
+             !Domain::equal(getOrExtract(In, *Index, Arg), Domain::Uninit))
+      Dom = getOrExtract(In, *Index, Arg);
+    Context.Null.push_back(Dom);
+  }
+}
+
+void NullPointerAnalysis::applySummary(CallInst *Call, const FunctionSummary &Summary,
+    const Memory *In, Memory &NOut) {
+  if (Call->getType()->isPointerTy())
+    NOut.set(Index->id(Call), Summary.Null);
+}
+
+FunctionSummary NullPointerAnalysis::analyzeContext(Function &F, const CallContext &Context) {
+  // The diagnostics of F were printed by analyze().
+  raw_ostream *Diagnostics = Log;
+  Log = &nulls();
+  EntryContext = &Context;
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, DomainLattice(), *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
+  doAnalysis(F, &Shared->get(pointerMode(F), Options.PointerThreads));
+
+  auto InState = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N); };
+  SetVector<Instruction *> Flagged;
+  for (Instruction &Inst : instructions(F)) {
+    if (check(&Inst, InState))
+      Flagged.insert(&Inst);
   }
+  FunctionSummary Summary;
+  summarize(F, InState, Flagged, Summary);
+
+  Fixpoint.reset();
+  EntryContext = nullptr;
+  Log = Diagnostics;
+  return Summary;
+}
+
+PreservedAnalyses NullPointerAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+  setup(F, FAM);
+  analyze(F);
+  report(F, outs());
+  return PreservedAnalyses::all();
+}
+
+void NullPointerAnalysis::setup(Function &F, FunctionAnalysisManager &FAM) {
+  // Number the values, instructions and blocks of F once; memories are keyed
+  // by value IDs and stored by block number. The values are numbered by the
+  // pointer analyses of F, shared with the other passes, so that their alias
+  // queries take the same IDs.
+  Shared = &FAM.getResult<PointerAnalysisPass>(F);
+  Index = &Shared->index();
+  Blocks = std::make_unique<FunctionIndex>(F);
+  Graph = Blocks.get();
+}
+
+void NullPointerAnalysis::analyze(Function &F) {
+  ErrorInsts.clear();
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, DomainLattice(), *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
 
   // The chaotic iteration algorithm is implemented inside doAnalysis().
-  auto PA = new PointerAnalysis(F);
-  doAnalysis(F, PA);
+  PointerMode Mode = pointerMode(F);
+  PointerAnalysis &PA = Shared->get(Mode, Options.PointerThreads);
+  if (Options.PrintPointers)
+    PA.print(*Log);
+  doAnalysis(F, &PA);
 
   // Check each instruction in function F for potential null pointer dereference error.
+  auto InState = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N); };
+  std::vector<bool> Flagged;
   for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
     auto Inst = &(*Iter);
-    if (check(Inst))
+    Flagged.push_back(check(Inst, InState));
+    if (Flagged.back())
       ErrorInsts.insert(Inst);
   }
 
-  printMap(F, InMap, OutMap);
-  outs() << "Potential Instructions by " << getAnalysisName() << ": \n";
+  if (Summaries)
+    summarize(F, InState, ErrorInsts, Summaries->summary(F));
+
+  printMap(*Log, *Graph, InState,
+      [this](unsigned N) -> const Memory & { return Fixpoint->outState(N); },
+      *Index);
+  if (Options.Stats) {
+    *Log << getAnalysisName() << " stats for " << F.getName() << ": "
+         << Fixpoint->blockVisits() << " block visits, " << Fixpoint->instVisits()
+         << " instruction visits (" << Graph->blocks() << " blocks, "
+         << Graph->size() << " instructions, " << pointerModeName(Mode)
+         << " pointer analysis)\n";
+    *Log << getAnalysisName() << " pointer constraints for " << F.getName() << ": ";
+    PA.printStats(*Log);
+    *Log << "\n";
+  }
+  if (Options.ComparePointers) {
+    PointerMode Other =
+        Mode == PointerMode::Andersen ? PointerMode::Steensgaard : PointerMode::Andersen;
+    unsigned Changed = countChangedVerdicts(F, Other, Flagged);
+    *Log << getAnalysisName() << " pointer modes for " << F.getName() << ": "
+         << Changed << " of " << Flagged.size() << " checks change verdict from "
+         << pointerModeName(Mode) << " to " << pointerModeName(Other) << "\n";
+  }
+  if (Options.TimeEdits)
+    timeEdits(F);
+
+  Fixpoint.reset();
+}
+
+void NullPointerAnalysis::report(Function &F, raw_ostream &Out) {
+  if (Options.Stats && Options.Contexts) {
+    *Log << getAnalysisName() << " contexts for " << F.getName() << ": ";
+    Summaries->printContexts(*Log, F);
+    *Log << "\n";
+  }
+  Out << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  Out << "Potential Instructions by " << getAnalysisName() << ": \n";
   for (auto Inst : ErrorInsts) {
-    outs() << *Inst << "\n";
+    Out << *Inst << "\n";
   }
+}
+
+PointerMode NullPointerAnalysis::pointerMode(Function &F) {
+  if (Options.Pointers != PointerMode::Auto)
+    return Options.Pointers;
 
-  for (auto Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
-    delete InMap[&(*Iter)];
-    delete OutMap[&(*Iter)];
+  unsigned NumPointers = 0;
+  for (VarId Var = 0; Var < Index->size(); ++Var) {
+    if (Index->value(Var)->getType()->isPointerTy())
+      ++NumPointers;
   }
-  return PreservedAnalyses::all();
+  if (Graph->size() > Options.SteensgaardInsts || NumPointers > Options.SteensgaardPointers)
+    return PointerMode::Steensgaard;
+  return PointerMode::Andersen;
+}
+
+unsigned NullPointerAnalysis::countChangedVerdicts(
+    Function &F, PointerMode Other, const std::vector<bool> &Flagged) {
+  PointerAnalysis &PA = Shared->get(Other, Options.PointerThreads);
+  if (Options.PrintPointers)
+    PA.print(*Log);
+  doAnalysis(F, &PA);
+
+  auto InState = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N); };
+  unsigned Changed = 0;
+  unsigned I = 0;
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
+    if (check(&*Iter, InState) != Flagged[I++])
+      ++Changed;
+  }
+  return Changed;
+}
+
+void NullPointerAnalysis::timeEdits(Function &F) {
+  using Clock = std::chrono::steady_clock;
+  auto Micros = [](Clock::duration D) {
+    return std::chrono::duration<double, std::micro>(D).count();
+  };
+
+  ValueIndex Edited(F);
+  IncrementalAnalysis Incremental(F, Edited);
+  std::vector<StoreInst *> Stores;
+  for (Instruction &I : instructions(F)) {
+    StoreInst *Store = dyn_cast<StoreInst>(&I);
+    if (Store && Store->getValueOperand()->getType()->isPointerTy())
+      Stores.push_back(Store);
+  }
+
+  // The aliases of the pointer stored through are what a client would ask
+  // for after each edit.
+  Clock::time_point Start = Clock::now();
+  for (StoreInst *Store : Stores) {
+    VarId Ptr = Edited.id(Store->getPointerOperand());
+    Incremental.erase(Store);
+    Incremental.aliasedAllocas(Ptr);
+    Incremental.insert(Store);
+    Incremental.aliasedAllocas(Ptr);
+  }
+  double Edit = Micros(Clock::now() - Start) / std::max<size_t>(1, 2 * Stores.size());
+
+  Start = Clock::now();
+  ValueIndex Fresh(F);
+  AndersenAnalysis Rebuilt(F, Fresh);
+  double Rebuild = Micros(Clock::now() - Start);
+
+  // The reinserted stores have new IDs, but the allocas keep theirs, so the
+  // rows of both analyses list the same allocas in the same order.
+  unsigned Differ = 0;
+  for (VarId Var = 0; Var < Fresh.size(); ++Var) {
+    const std::vector<VarId> &Expected = Rebuilt.aliasedAllocas(Var);
+    const std::vector<VarId> &Actual = Incremental.aliasedAllocas(Edited.id(Fresh.value(Var)));
+    bool Same = Expected.size() == Actual.size();
+    for (size_t I = 0; Same && I < Actual.size(); ++I)
+      Same = Fresh.value(Expected[I]) == Edited.value(Actual[I]);
+    if (!Same)
+      ++Differ;
+  }
+
+  *Log << getAnalysisName() << " pointer edits for " << F.getName() << ": "
+       << 2 * Stores.size() << " edits, " << format("%.1f", Edit)
+       << " us per edit and query, " << format("%.1f", Rebuild) << " us per rebuild, "
+       << Differ << " pointers differ from the rebuild\n";
 }
 
 extern "C" LLVM_ATTRIBUTE_WEAK ::llvm::PassPluginLibraryInfo llvmGetPassPluginInfo() {
   return {LLVM_PLUGIN_API_VERSION, "NullPtr", "v0.1", [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback([](FunctionAnalysisManager &FAM) {
+              FAM.registerPass([] { return PointerAnalysisPass(); });
+            });
             PB.registerPipelineParsingCallback(
                 [](StringRef Name,
                     ModulePassManager &MPM,
                     ArrayRef<PassBuilder::PipelineElement>) {
-                  if (Name == "NullPtr") {
-                    MPM.addPass(createModuleToFunctionPassAdaptor(NullPointerAnalysis()));
+                  DataflowOptions Options;
+                  if (parsePassName(Name, "NullPtr", Options)) {
+                    MPM.addPass(ParallelDriver<NullPointerAnalysis>(Options));
                     return true;
                   }
                   return false;
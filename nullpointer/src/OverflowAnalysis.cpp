@@ -1,48 +1,22 @@
 #include "OverflowAnalysis.h"
 #include "DomainOverflow.h"
+#include "ParallelDriver.h"
 #include "Utils.h"
 
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ScalarEvolution.h"
+#include "llvm/Analysis/ScalarEvolutionExpressions.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/CFG.h"
 
+#include <set>
+
 using namespace llvm;
 using overflow::DomainOverflow;
 
 namespace dataflow {
 
-std::vector<Instruction *> getPredecessors(Instruction *Inst);
-std::vector<Instruction *> getSuccessors(Instruction *Inst);
-
-// Simple loop header detection: check if a PHI node has a back edge
-// A back edge exists if a predecessor block can reach the PHI's block
-static bool isLoopHeader(PHINode *PN) {
-  if (!PN) return false;
-
-  BasicBlock *PhiBB = PN->getParent();
-
-  // Check if any predecessor is a back edge (comes from a block that
-  // the PHI's block can reach - indicating a loop)
-  for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i) {
-    BasicBlock *PredBB = PN->getIncomingBlock(i);
-
-    // Simple heuristic: if predecessor is a successor of the PHI's block
-    // in the CFG, it's likely a back edge
-    for (auto *Succ : successors(PhiBB)) {
-      if (Succ == PredBB) {
-        return true; // Back edge detected
-      }
-      // Also check one level deeper for loops
-      for (auto *Succ2 : successors(Succ)) {
-        if (Succ2 == PredBB) {
-          return true;
-        }
-      }
-    }
-  }
-
-  return false;
-}
-
 // ===----------------------------------------------------------------------===//
 // Local helpers (overflow-specific)
 // ===----------------------------------------------------------------------===//
@@ -55,15 +29,14 @@ using dataflow::variable;
 
 // Get a domain element for Val from Mem, or synthesize it.
 //
-//  - If Mem has an entry for variable(Val), return it.
+//  - If Mem has an entry for the ID of Val, return it.
 //  - If Val is a ConstantInt, return [v, v].
 //  - Otherwise, return TOP ([-inf, +inf]).
 DomainOverflow getOrExtractOverflow(const OverflowMemory &Mem,
+                                    const ValueIndex &Index,
                                     const Value *Val) {
-  std::string name = variable(Val);
-  auto It = Mem.find(name);
-  if (It != Mem.end())
-    return It->second;
+  if (const DomainOverflow *Dom = Mem.find(Index.lookup(Val)))
+    return *Dom;
 
   if (auto *CI = dyn_cast<ConstantInt>(Val)) {
     // For small bit widths (8-bit, 16-bit), we need to consider both
@@ -91,45 +64,270 @@ DomainOverflow getOrExtractOverflow(const OverflowMemory &Mem,
   return DomainOverflow::top();
 }
 
-// Compare two memories for equality using DomainOverflow::equal.
-bool memoryEqual(const OverflowMemory &A, const OverflowMemory &B) {
-  if (A.size() != B.size())
-    return false;
+// Optional pretty-print helpers (only used inside this file).
+void printOverflowMemory(const OverflowMemory &Mem, const ValueIndex &Index) {
+  Mem.forEach([&](VarId Var, const DomainOverflow &Dom) {
+    errs() << "  [ " << Index.name(Var) << " |-> ";
+    Dom.print(errs());
+    errs() << " ]\n";
+  });
+}
 
-  for (const auto &KV : A) {
-    auto It = B.find(KV.first);
-    if (It == B.end())
-      return false;
-    if (!DomainOverflow::equal(KV.second, It->second))
-      return false;
+// void printOverflowMap(const FunctionIndex &Graph,
+//                       function_ref<const OverflowMemory &(unsigned)> InState,
+//                       function_ref<const OverflowMemory &(unsigned)> OutState,
+//                       const ValueIndex &Index) {
+//   for (unsigned N = 0; N < Graph.size(); ++N) {
+//     errs() << *Graph.instruction(N) << "\n";
+//     errs() << "  IN:\n";
+//     printOverflowMemory(InState(N), Index);
+//     errs() << "  OUT:\n";
+//     printOverflowMemory(OutState(N), Index);
+//     errs() << "\n";
+//   }
+// }
+
+// Bounds one step inside an interval, keeping infinities.
+long long incBound(long long v) {
+  return v == DomainOverflow::NEG_INF || v == DomainOverflow::POS_INF ? v : v + 1;
+}
+
+long long decBound(long long v) {
+  return v == DomainOverflow::NEG_INF || v == DomainOverflow::POS_INF ? v : v - 1;
+}
+
+// Remove the value C from Dom if it is one of its bounds.
+DomainOverflow exclude(const DomainOverflow &Dom, long long C) {
+  if (Dom.isBottom)
+    return Dom;
+  if (Dom.low == C && Dom.high == C)
+    return DomainOverflow::bottom();
+  if (Dom.low == C)
+    return DomainOverflow(incBound(C), Dom.high);
+  if (Dom.high == C)
+    return DomainOverflow(Dom.low, decBound(C));
+  return Dom;
+}
+
+// Refine the operands of the branch condition of Pred in Mem for the edge
+// Pred -> Succ. Returns false if the condition cannot hold on that edge.
+bool refineEdge(OverflowMemory &Mem, const ValueIndex &Index,
+                BasicBlock *Pred, BasicBlock *Succ) {
+  auto *Br = dyn_cast<BranchInst>(Pred->getTerminator());
+  if (!Br || !Br->isConditional() || Br->getSuccessor(0) == Br->getSuccessor(1))
+    return true;
+  auto *Cmp = dyn_cast<ICmpInst>(Br->getCondition());
+  if (!Cmp || !Cmp->getOperand(0)->getType()->isIntegerTy())
+    return true;
+
+  CmpInst::Predicate P = Cmp->getPredicate();
+  if (Br->getSuccessor(1) == Succ)
+    P = CmpInst::getInversePredicate(P);
+
+  Value *A = Cmp->getOperand(0);
+  Value *B = Cmp->getOperand(1);
+  DomainOverflow L = getOrExtractOverflow(Mem, Index, A);
+  DomainOverflow R = getOrExtractOverflow(Mem, Index, B);
+  if (L.isBottom || R.isBottom)
+    return true;
+
+  // Unsigned comparisons agree with signed ones on non-negative intervals.
+  if (ICmpInst::isUnsigned(P)) {
+    if (L.low < 0 || R.low < 0)
+      return true;
+    P = ICmpInst::getSignedPredicate(P);
   }
+
+  const long long NI = DomainOverflow::NEG_INF, PI = DomainOverflow::POS_INF;
+  DomainOverflow NL = L, NR = R;
+  switch (P) {
+  case CmpInst::ICMP_EQ:
+    NL = NR = DomainOverflow::meet(L, R);
+    break;
+  case CmpInst::ICMP_NE:
+    if (R.low == R.high)
+      NL = exclude(L, R.low);
+    if (L.low == L.high)
+      NR = exclude(R, L.low);
+    break;
+  case CmpInst::ICMP_SLT:
+    NL = DomainOverflow::meet(L, DomainOverflow(NI, decBound(R.high)));
+    NR = DomainOverflow::meet(R, DomainOverflow(incBound(L.low), PI));
+    break;
+  case CmpInst::ICMP_SLE:
+    NL = DomainOverflow::meet(L, DomainOverflow(NI, R.high));
+    NR = DomainOverflow::meet(R, DomainOverflow(L.low, PI));
+    break;
+  case CmpInst::ICMP_SGT:
+    NL = DomainOverflow::meet(L, DomainOverflow(incBound(R.low), PI));
+    NR = DomainOverflow::meet(R, DomainOverflow(NI, decBound(L.high)));
+    break;
+  case CmpInst::ICMP_SGE:
+    NL = DomainOverflow::meet(L, DomainOverflow(R.low, PI));
+    NR = DomainOverflow::meet(R, DomainOverflow(NI, L.high));
+    break;
+  default:
+    return true;
+  }
+
+  if (NL.isBottom || NR.isBottom)
+    return false;
+
+  // Constants are not in the memory and need no refinement.
+  if (!isa<Constant>(A))
+    Mem.set(Index.id(A), NL);
+  if (!isa<Constant>(B))
+    Mem.set(Index.id(B), NR);
   return true;
 }
 
-// Optional pretty-print helpers (only used inside this file).
-void printOverflowMemory(const OverflowMemory &Mem) {
-  for (const auto &KV : Mem) {
-    errs() << "  [ " << KV.first << " |-> ";
-    KV.second.print(errs());
-    errs() << " ]\n";
+// Add V to Thresholds if it is strictly between the infinity sentinels.
+void addThreshold(std::vector<long long> &Thresholds, long long V) {
+  if (V > DomainOverflow::NEG_INF && V < DomainOverflow::POS_INF)
+    Thresholds.push_back(V);
+}
+
+// Collect the widening thresholds of F, sorted: the constants compared
+// against (and their neighbours, since i < c bounds i + 1 by c), the signed
+// and unsigned bounds of every integer width used, and array sizes.
+std::vector<long long> collectThresholds(Function &F) {
+  std::vector<long long> Thresholds;
+  std::set<unsigned> Widths;
+
+  for (Instruction &I : instructions(F)) {
+    if (I.getType()->isIntegerTy())
+      Widths.insert(I.getType()->getIntegerBitWidth());
+
+    if (auto *Cmp = dyn_cast<ICmpInst>(&I)) {
+      for (Value *Op : Cmp->operands()) {
+        auto *CI = dyn_cast<ConstantInt>(Op);
+        if (!CI || CI->getBitWidth() > 64)
+          continue;
+        long long V = CI->getSExtValue();
+        addThreshold(Thresholds, V);
+        if (V > DomainOverflow::NEG_INF)
+          addThreshold(Thresholds, V - 1);
+        if (V < DomainOverflow::POS_INF)
+          addThreshold(Thresholds, V + 1);
+      }
+    }
+
+    Type *Ty = nullptr;
+    if (auto *Alloca = dyn_cast<AllocaInst>(&I))
+      Ty = Alloca->getAllocatedType();
+    else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I))
+      Ty = GEP->getSourceElementType();
+    for (; Ty && Ty->isArrayTy(); Ty = Ty->getArrayElementType()) {
+      uint64_t N = Ty->getArrayNumElements();
+      if (N < (uint64_t)DomainOverflow::POS_INF) {
+        addThreshold(Thresholds, N);
+        addThreshold(Thresholds, (long long)N - 1);
+      }
+    }
+  }
+
+  for (unsigned BW : Widths) {
+    if (BW >= 63)
+      continue;
+    addThreshold(Thresholds, -(1LL << (BW - 1)));
+    addThreshold(Thresholds, (1LL << (BW - 1)) - 1);
+    addThreshold(Thresholds, (1LL << BW) - 1);
   }
+
+  std::sort(Thresholds.begin(), Thresholds.end());
+  Thresholds.erase(std::unique(Thresholds.begin(), Thresholds.end()),
+                   Thresholds.end());
+  return Thresholds;
 }
 
-// void printOverflowMap(Function &F,
-//                       std::map<Instruction *, OverflowMemory *> &InMap,
-//                       std::map<Instruction *, OverflowMemory *> &OutMap) {
-//   for (auto &BB : F) {
-//     for (auto &I : BB) {
-//       Instruction *Inst = &I;
-//       errs() << Inst << "\n";
-//       errs() << "  IN:\n";
-//       printOverflowMemory(*InMap[Inst]);
-//       errs() << "  OUT:\n";
-//       printOverflowMemory(*OutMap[Inst]);
-//       errs() << "\n";
-//     }
-//   }
-// }
+// Closed-form intervals of the integer PHIs of loop headers. ScalarEvolution
+// describes such a PHI as an add-recurrence {Start,+,Step} of its loop; when
+// Start and Step are constants and the backedge-taken count of the loop is
+// bounded by a constant BTC, the PHI takes the values Start + Step*k for k in
+// [0, BTC]. A recurrence whose last value leaves the signed range of its
+// type may wrap, and is left to the fixpoint.
+DenseMap<VarId, DomainOverflow>
+collectInductionRanges(const ValueIndex &Index, LoopInfo &LI,
+                       ScalarEvolution &SE) {
+  DenseMap<VarId, DomainOverflow> Ranges;
+
+  for (Loop *L : LI.getLoopsInPreorder()) {
+    auto *BTC = dyn_cast<SCEVConstant>(SE.getConstantMaxBackedgeTakenCount(L));
+    if (!BTC)
+      continue;
+
+    for (PHINode &PN : L->getHeader()->phis()) {
+      if (!PN.getType()->isIntegerTy() ||
+          PN.getType()->getIntegerBitWidth() > 64)
+        continue;
+      auto *AR = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(&PN));
+      if (!AR || AR->getLoop() != L || !AR->isAffine())
+        continue;
+      auto *Start = dyn_cast<SCEVConstant>(AR->getStart());
+      auto *Step = dyn_cast<SCEVConstant>(AR->getStepRecurrence(SE));
+      if (!Start || !Step || BTC->getAPInt().getActiveBits() > 64)
+        continue;
+
+      // Start + Step*BTC cannot overflow 130 bits.
+      unsigned BW = PN.getType()->getIntegerBitWidth();
+      APInt First = Start->getAPInt().sext(130);
+      APInt Last = First + Step->getAPInt().sext(130) *
+                               BTC->getAPInt().zextOrTrunc(130);
+      APInt Min = APInt::getSignedMinValue(BW).sext(130);
+      APInt Max = APInt::getSignedMaxValue(BW).sext(130);
+      if (Last.slt(Min) || Last.sgt(Max))
+        continue;
+
+      long long Lo = std::min(First.getSExtValue(), Last.getSExtValue());
+      long long Hi = std::max(First.getSExtValue(), Last.getSExtValue());
+      if (Lo == DomainOverflow::NEG_INF || Hi == DomainOverflow::POS_INF)
+        continue;
+      Ranges[Index.id(&PN)] = DomainOverflow(Lo, Hi);
+    }
+  }
+  return Ranges;
+}
+
+// If Val is argument Arg plus an offset in Offset, whatever the arguments,
+// set them and return true. Offsets go through additions and subtractions
+// of constants, and PHIs of such values of the same argument.
+bool argumentOffset(Value *Val, int &Arg, DomainOverflow &Offset,
+                    SmallPtrSetImpl<PHINode *> &Visited) {
+  if (auto *A = dyn_cast<Argument>(Val)) {
+    if (Arg >= 0 && Arg != (int)A->getArgNo())
+      return false;
+    Arg = A->getArgNo();
+    Offset = DomainOverflow(0, 0);
+    return true;
+  }
+
+  if (auto *BO = dyn_cast<BinaryOperator>(Val)) {
+    auto *C = dyn_cast<ConstantInt>(BO->getOperand(1));
+    if (!C || C->getBitWidth() > 64 ||
+        (BO->getOpcode() != Instruction::Add &&
+         BO->getOpcode() != Instruction::Sub) ||
+        !argumentOffset(BO->getOperand(0), Arg, Offset, Visited))
+      return false;
+    DomainOverflow Const(C->getSExtValue(), C->getSExtValue());
+    Offset = BO->getOpcode() == Instruction::Add
+                 ? DomainOverflow::add(Offset, Const)
+                 : DomainOverflow::sub(Offset, Const);
+    return true;
+  }
+
+  // A PHI on a cycle adds its offsets again at each iteration.
+  auto *PN = dyn_cast<PHINode>(Val);
+  if (!PN || !Visited.insert(PN).second)
+    return false;
+  DomainOverflow Joined = DomainOverflow::bottom();
+  for (Value *Incoming : PN->incoming_values()) {
+    if (!argumentOffset(Incoming, Arg, Offset, Visited))
+      return false;
+    Joined = DomainOverflow::join(Joined, Offset);
+  }
+  Offset = Joined;
+  return true;
+}
 
 } // end anonymous namespace
 
@@ -139,24 +337,24 @@ void printOverflowMemory(const OverflowMemory &Mem) {
 //
 // NOut starts as a copy of In. Then we update it based on Inst.
 //
-// We only track integer-producing instructions (binary ops, PHI).
-// Other instructions just propagate the input state unchanged.
+// Every integer-producing instruction gets an entry: binary ops and PHIs
+// are evaluated, the rest are top. A variable missing from a memory is
+// therefore not defined on the paths reaching it (Bottom), which is what
+// lets joins skip values from paths that have not been evaluated yet.
 //
 
 void OverflowAnalysis::transfer(Instruction *I,
                                 const OverflowMemory *In,
                                 OverflowMemory &NOut) {
-  // Start from incoming memory
-  NOut = *In;
-
   // Binary integer operations
   if (auto *BO = dyn_cast<BinaryOperator>(I)) {
     if (!BO->getType()->isIntegerTy())
       return;
 
-    DomainOverflow L = getOrExtractOverflow(*In, BO->getOperand(0));
-    DomainOverflow R = getOrExtractOverflow(*In, BO->getOperand(1));
-    DomainOverflow Res;
+    DomainOverflow L = getOrExtractOverflow(*In, *Index, BO->getOperand(0));
+    DomainOverflow R = getOrExtractOverflow(*In, *Index, BO->getOperand(1));
+    // Other binary ops are not modeled by this analysis
+    DomainOverflow Res = DomainOverflow::top();
 
     switch (BO->getOpcode()) {
     case Instruction::Add:
@@ -172,11 +370,10 @@ void OverflowAnalysis::transfer(Instruction *I,
       Res = DomainOverflow::shl(L, R);
       break;
     default:
-      // Other binary ops are ignored for this analysis
-      return;
+      break;
     }
 
-    NOut[variable(I)] = Res;
+    NOut.set(Index->id(I), Res);
     return;
   }
 
@@ -185,12 +382,23 @@ void OverflowAnalysis::transfer(Instruction *I,
     if (!PN->getType()->isIntegerTy())
       return;
 
+    // Induction variables solved by ScalarEvolution keep their closed form.
+    auto Range = InductionRanges.find(Index->id(I));
+    if (Range != InductionRanges.end()) {
+      NOut.set(Index->id(I), Range->second);
+      return;
+    }
+
     bool first = true;
     DomainOverflow Acc = DomainOverflow::bottom();
 
     for (unsigned i = 0, e = PN->getNumIncomingValues(); i < e; ++i) {
+      // Values from blocks that have not been evaluated yet are Bottom.
+      if (!Reached(Graph->blockNumber(PN->getIncomingBlock(i))))
+        continue;
+
       Value *V = PN->getIncomingValue(i);
-      DomainOverflow VDom = getOrExtractOverflow(*In, V);
+      DomainOverflow VDom = getOrExtractOverflow(*In, *Index, V);
       if (first) {
         Acc = VDom;
         first = false;
@@ -199,141 +407,72 @@ void OverflowAnalysis::transfer(Instruction *I,
       }
     }
 
-    if (!first) { // had at least one incoming value
-      std::string var = variable(I);
-
-      // Apply widening at loop headers for faster convergence
-      if (isLoopHeader(PN)) {
-        // Check if we have an old value for this PHI
-        auto OldIt = In->find(var);
-        if (OldIt != In->end()) {
-          // Apply widening operator: compare old vs new interval
-          Acc = DomainOverflow::widen(OldIt->second, Acc);
-        }
-      }
-
-      NOut[var] = Acc;
-    }
+    // Widening is applied to the IN memory of WTO component heads, which
+    // cuts every cycle, so the PHI itself is a plain join.
+    if (!first) // had at least one incoming value
+      NOut.set(Index->id(I), Acc);
 
     return;
   }
 
-  // Other instructions: nothing special, just propagate NOut = In.
-}
-
-// ===----------------------------------------------------------------------===//
-// flowIn: meet over all predecessors
-// ===----------------------------------------------------------------------===//
-
-void OverflowAnalysis::flowIn(Instruction *Inst, OverflowMemory *InMem) {
-  InMem->clear();
-
-  // Instruction-level predecessors (previous instruction in block,
-  // or terminators of predecessor blocks).
-  std::vector<Instruction *> Preds = getPredecessors(Inst);
-
-  // No predecessors (first instruction overall) → leave InMem empty.
-  if (Preds.empty())
-    return;
-
-  bool firstPred = true;
-  OverflowMemory Acc;
-
-  for (Instruction *Pred : Preds) {
-    OverflowMemory *PredOut = OutMap[Pred];
-
-    if (firstPred) {
-      // Initialize accumulator with predecessor OUT
-      Acc = *PredOut;
-      firstPred = false;
-    } else {
-      // Join Acc with PredOut element-wise.
-      OverflowMemory NewAcc;
-
-      // Keys from Acc
-      for (const auto &KV : Acc) {
-        const std::string &name = KV.first;
-        auto It2 = PredOut->find(name);
-        if (It2 != PredOut->end()) {
-          NewAcc[name] = DomainOverflow::join(KV.second, It2->second);
-        } else {
-          NewAcc[name] = DomainOverflow::join(KV.second,
-                                              DomainOverflow::top());
-        }
-      }
-
-      // Keys only in PredOut
-      for (const auto &KV : *PredOut) {
-        const std::string &name = KV.first;
-        if (Acc.find(name) == Acc.end()) {
-          NewAcc[name] = DomainOverflow::join(DomainOverflow::top(),
-                                              KV.second);
-        }
-      }
-
-      Acc = std::move(NewAcc);
+  // A call returns the interval of the summary of its callee, and its
+  // argument shifted by the offset of the summary
+  if (auto *Call = dyn_cast<CallInst>(I)) {
+    if (const FunctionSummary *Summary = callSummary(Call, In)) {
+      applySummary(Call, *Summary, In, NOut);
+      return;
     }
   }
 
-  *InMem = std::move(Acc);
+  // Other integer instructions (loads, casts, calls, ...) are not modeled:
+  // their result is any value.
+  if (I->getType()->isIntegerTy())
+    NOut.set(Index->id(I), DomainOverflow::top());
 }
 
-
 // ===----------------------------------------------------------------------===//
-// flowOut: update OutMap and workset
+// Boundary and edges
 // ===----------------------------------------------------------------------===//
-void OverflowAnalysis::flowOut(Instruction *Inst,
-                               OverflowMemory *Pre,
-                               OverflowMemory *Post,
-                               SetVector<Instruction *> &WorkSet) {
-  if (memoryEqual(*Pre, *Post))
-    return;
 
-  *Pre = *Post;
-
-  // Re-enqueue successors if OUT changed.
-  std::vector<Instruction *> Succs = getSuccessors(Inst);
-  for (Instruction *Succ : Succs) {
-    WorkSet.insert(Succ);
+void OverflowAnalysis::entry(OverflowMemory &InMem) {
+  // The entry block is reachable, and the arguments can be any value,
+  // unless a call context gives them.
+  for (Argument &Arg : Graph->basicBlock(0)->getParent()->args()) {
+    if (!Arg.getType()->isIntegerTy())
+      continue;
+    if (EntryContext && !EntryContext->Ranges.empty())
+      InMem.set(Index->id(&Arg), EntryContext->Ranges[Arg.getArgNo()]);
+    else
+      InMem.set(Index->id(&Arg), DomainOverflow::top());
   }
 }
 
+bool OverflowAnalysis::edge(unsigned Pred, unsigned B, OverflowMemory &Mem) {
+  return refineEdge(Mem, *Index, Graph->basicBlock(Pred),
+                    Graph->basicBlock(B));
+}
 
 // ===----------------------------------------------------------------------===//
-// Chaotic iteration driver
+// Recursive iteration strategy (Bourdoncle)
 // ===----------------------------------------------------------------------===//
+//
+// The engine evaluates the blocks in WTO order and stabilizes every
+// component, joining at its head for the first rounds of a loop and
+// widening after, then narrowing once it is stable.
+//
 
-void OverflowAnalysis::doAnalysis(Function &F) {
-  SetVector<Instruction *> WorkSet;
-
-  // Initialize workset with ALL instructions.
-  for (Instruction &I : instructions(F)) {
-    WorkSet.insert(&I);
-  }
-
-  while (!WorkSet.empty()) {
-    Instruction *Inst = WorkSet.pop_back_val();
-
-    OverflowMemory *InMem = InMap[Inst];
-    OverflowMemory *OutMem = OutMap[Inst];
-
-    // Compute IN
-    flowIn(Inst, InMem);
-
-    // Compute OUT via transfer
-    OverflowMemory NewOut;
-    transfer(Inst, InMem, NewOut);
-
-    // Merge with previous OUT and update workset
-    flowOut(Inst, OutMem, &NewOut, WorkSet);
-  }
+void OverflowAnalysis::doAnalysis(Function &F,
+                                  const WeakTopologicalOrder &WTO) {
+  Fixpoint->solve(
+      RecursiveIteration(WTO, WideningDelays, Options.NarrowIterations));
 }
 
 // ===----------------------------------------------------------------------===//
 // Overflow check
 // ===----------------------------------------------------------------------===//
 
-bool OverflowAnalysis::check(Instruction *Inst) {
+bool OverflowAnalysis::check(
+    Instruction *Inst, function_ref<const OverflowMemory &(unsigned)> OutState) {
   auto *BO = dyn_cast<BinaryOperator>(Inst);
   if (!BO)
     return false;
@@ -349,9 +488,14 @@ bool OverflowAnalysis::check(Instruction *Inst) {
   if (!Ty->isIntegerTy())
     return false;
 
+  // Instructions in unreachable blocks cannot overflow.
+  unsigned N = Graph->number(Inst);
+  if (!Reached(Graph->block(N)))
+    return false;
+
   // Get the OUT interval for this instruction's result.
-  OverflowMemory *OutMem = OutMap[Inst];
-  DomainOverflow ResDom = getOrExtractOverflow(*OutMem, Inst);
+  const OverflowMemory &OutMem = OutState(N);
+  DomainOverflow ResDom = getOrExtractOverflow(OutMem, *Index, Inst);
 
   if (ResDom.isBottom)
     return false; // unreachable
@@ -403,47 +547,197 @@ bool OverflowAnalysis::check(Instruction *Inst) {
   return false;
 }
 
+// ===----------------------------------------------------------------------===//
+// Summary
+// ===----------------------------------------------------------------------===//
+
+void OverflowAnalysis::summarize(
+    Function &F, function_ref<const OverflowMemory &(unsigned)> OutState,
+    FunctionSummary &Summary) {
+  Summary.Range = DomainOverflow::bottom();
+  Summary.RangeArg = -1;
+  Summary.RangeOffset = DomainOverflow::bottom();
+  if (!F.getReturnType()->isIntegerTy())
+    return;
+
+  int Arg = -1;
+  bool Offsets = true;
+  DomainOverflow Offset = DomainOverflow::bottom();
+  for (Instruction &I : instructions(F)) {
+    auto *Return = dyn_cast<ReturnInst>(&I);
+    if (!Return || !Reached(Graph->block(Graph->number(Return))))
+      continue;
+    unsigned N = Graph->number(Return);
+    Value *Val = Return->getReturnValue();
+    Summary.Range = DomainOverflow::join(
+        Summary.Range, getOrExtractOverflow(OutState(N), *Index, Val));
+
+    SmallPtrSet<PHINode *, 8> Visited;
+    DomainOverflow Returned;
+    Offsets = Offsets && argumentOffset(Val, Arg, Returned, Visited);
+    if (Offsets)
+      Offset = DomainOverflow::join(Offset, Returned);
+  }
+  if (Offsets && Arg >= 0) {
+    Summary.RangeArg = Arg;
+    Summary.RangeOffset = Offset;
+  }
+}
+
+const FunctionSummary *OverflowAnalysis::callSummary(CallInst *Call,
+                                                     const OverflowMemory *In) {
+  if (!Summaries)
+    return nullptr;
+  if (!Options.Contexts)
+    return Summaries->lookup(*Call);
+  CallContext Context;
+  addArguments(Call, In, Context);
+  return Summaries->lookup(*Call, Context, Slots);
+}
+
+void OverflowAnalysis::addArguments(CallInst *Call, const OverflowMemory *In,
+                                    CallContext &Context) {
+  // An argument the caller knows nothing of is top, as on entry.
+  for (Value *Arg : Call->args()) {
+    DomainOverflow Range = DomainOverflow::top();
+    if (Arg->getType()->isIntegerTy()) {
+      Range = getOrExtractOverflow(*In, *Index, Arg);
+      if (Range.isBottom)
+        Range = DomainOverflow::top();
+    }
+    Context.Ranges.push_back(Range);
+  }
+}
+
+void OverflowAnalysis::applySummary(CallInst *Call,
+                                    const FunctionSummary &Summary,
+                                    const OverflowMemory *In,
+                                    OverflowMemory &NOut) {
+  if (!Call->getType()->isIntegerTy())
+    return;
+  DomainOverflow Res = Summary.Range;
+  if (Summary.RangeArg >= 0) {
+    DomainOverflow Arg = getOrExtractOverflow(
+        *In, *Index, Call->getArgOperand(Summary.RangeArg));
+    Res = DomainOverflow::meet(Res,
+                               DomainOverflow::add(Arg, Summary.RangeOffset));
+  }
+  NOut.set(Index->id(Call), Res);
+}
+
+FunctionSummary OverflowAnalysis::analyzeContext(Function &F,
+                                                 const CallContext &Context) {
+  EntryContext = &Context;
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, OverflowLattice{&Thresholds},
+                                      *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
+  doAnalysis(F, *WTO);
+
+  FunctionSummary Summary;
+  summarize(F,
+            [this](unsigned N) -> const OverflowMemory & {
+              return Fixpoint->outState(N);
+            },
+            Summary);
+
+  Fixpoint.reset();
+  EntryContext = nullptr;
+  return Summary;
+}
+
 // ===----------------------------------------------------------------------===//
 // Pass entry point
 // ===----------------------------------------------------------------------===//
 
 PreservedAnalyses OverflowAnalysis::run(Function &F,
-                                        FunctionAnalysisManager &) {
-  outs() << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+                                        FunctionAnalysisManager &FAM) {
+  setup(F, FAM);
+  analyze(F);
+  report(F, outs());
+  return PreservedAnalyses::all();
+}
 
-  // Initialize InMap and OutMap.
-  for (inst_iterator It = inst_begin(F), End = inst_end(F); It != End; ++It) {
-    Instruction *Inst = &*It;
-    InMap[Inst]  = new OverflowMemory;
-    OutMap[Inst] = new OverflowMemory;
-  }
+void OverflowAnalysis::setup(Function &F, FunctionAnalysisManager &FAM) {
+  // Number the values, instructions and blocks of F once; memories are keyed
+  // by value IDs and stored by block number.
+  Values = std::make_unique<ValueIndex>(F);
+  Blocks = std::make_unique<FunctionIndex>(F);
+  WTO = std::make_unique<WeakTopologicalOrder>(*Blocks);
+  Index = Values.get();
+  Graph = Blocks.get();
+  prepare(F, FAM);
+}
+
+void OverflowAnalysis::analyze(Function &F) {
+  ErrorInsts.clear();
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Graph, OverflowLattice{&Thresholds},
+                                      *this);
+  Reached = [this](unsigned B) { return Fixpoint->evaluated(B); };
 
   // Chaotic iteration.
-  doAnalysis(F);
+  doAnalysis(F, *WTO);
 
   // Check each instruction for possible overflow.
+  auto OutState = [this](unsigned N) -> const OverflowMemory & {
+    return Fixpoint->outState(N);
+  };
   for (inst_iterator It = inst_begin(F), End = inst_end(F); It != End; ++It) {
     Instruction *Inst = &*It;
-    if (check(Inst))
+    if (check(Inst, OutState))
       ErrorInsts.insert(Inst);
   }
 
+  if (Summaries)
+    summarize(F, OutState, Summaries->summary(F));
+
   // Optional: print the analysis result
-  // printOverflowMap(F, InMap, OutMap);
+  // printOverflowMap(*Graph,
+  //     [this](unsigned N) -> const OverflowMemory & { return Fixpoint->inState(N); },
+  //     OutState,
+  //     *Index);
+
+  if (Options.Stats) {
+    *Log << getAnalysisName() << " stats for " << F.getName() << ": "
+         << Fixpoint->blockVisits() << " block visits, " << Fixpoint->instVisits()
+         << " instruction visits, " << InductionRanges.size()
+         << " closed-form induction variables (" << Graph->blocks() << " blocks, "
+         << Graph->size() << " instructions)\n";
+  }
+
+  // Cleanup; the numbering stays for analyzeContext()
+  Fixpoint.reset();
+}
 
-  outs() << "Potential Overflow Instructions by " << getAnalysisName() << ":\n";
+void OverflowAnalysis::report(Function &F, raw_ostream &Out) {
+  if (Options.Stats && Options.Contexts) {
+    *Log << getAnalysisName() << " contexts for " << F.getName() << ": ";
+    Summaries->printContexts(*Log, F);
+    *Log << "\n";
+  }
+  Out << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  Out << "Potential Overflow Instructions by " << getAnalysisName() << ":\n";
   for (auto *Inst : ErrorInsts) {
-    outs() << *Inst << "\n";
+    Out << *Inst << "\n";
   }
+}
 
-  // Cleanup
-  for (inst_iterator It = inst_begin(F), End = inst_end(F); It != End; ++It) {
-    Instruction *Inst = &*It;
-    delete InMap[Inst];
-    delete OutMap[Inst];
+void OverflowAnalysis::prepare(Function &F, FunctionAnalysisManager &FAM) {
+  Thresholds = collectThresholds(F);
+
+  // LoopInfo loops get the widening delay. A cycle LoopInfo does not
+  // recognize (irreducible control flow) is widened right away.
+  LoopInfo &LI = FAM.getResult<LoopAnalysis>(F);
+  WideningDelays.assign(Graph->blocks(), 0);
+  for (unsigned B = 0; B < Graph->blocks(); ++B) {
+    if (LI.isLoopHeader(Graph->basicBlock(B)))
+      WideningDelays[B] = Options.WidenDelay;
   }
 
-  return PreservedAnalyses::all();
+  // Affine loop counters get their interval from ScalarEvolution up front.
+  ScalarEvolution &SE = FAM.getResult<ScalarEvolutionAnalysis>(F);
+  InductionRanges = collectInductionRanges(*Index, LI, SE);
 }
 
 // ===----------------------------------------------------------------------===//
@@ -457,9 +751,9 @@ llvmGetPassPluginInfo() {
             PB.registerPipelineParsingCallback(
                 [](StringRef Name, ModulePassManager &MPM,
                    ArrayRef<PassBuilder::PipelineElement>) {
-                  if (Name == "Overflow") {
-                    MPM.addPass(
-                        createModuleToFunctionPassAdaptor(OverflowAnalysis()));
+                  DataflowOptions Options;
+                  if (parsePassName(Name, "Overflow", Options)) {
+                    MPM.addPass(ParallelDriver<OverflowAnalysis>(Options));
                     return true;
                   }
                   return false;
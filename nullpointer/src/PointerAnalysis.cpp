@@ -1,96 +1,214 @@
 #include "PointerAnalysis.h"
 
+#include "AndersenAnalysis.h"
+#include "FlowSensitiveAnalysis.h"
+#include "SteensgaardAnalysis.h"
 #include "Utils.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 
+#include <cassert>
+#include <string>
+#include <utility>
+
 namespace dataflow {
 
-void PointerAnalysis::transfer(Instruction *Inst, PointsToInfo &PointsTo) {
-  if (AllocaInst *Alloca = dyn_cast<AllocaInst>(Inst)) {
-    std::string Pointer = variable(Alloca);
-    PointsToSet &S = PointsTo[variable(Alloca)];
-    S.insert(address(Alloca));
-  } else if (StoreInst *Store = dyn_cast<StoreInst>(Inst)) {
-    if (!Store->getValueOperand()->getType()->isPointerTy())
-      return;
-    Value *Pointer = Store->getPointerOperand();
-    Value *Value = Store->getValueOperand();
-    PointsToSet &L = PointsTo[variable(Pointer)];
-    PointsToSet &R = PointsTo[variable(Value)];
-    for (auto &I : L) {
-      PointsToSet &S = PointsTo[I];
-      PointsToSet Result;
-      std::set_union(
-          S.begin(), S.end(), R.begin(), R.end(), std::inserter(Result, Result.begin()));
-      PointsTo[I] = Result;
+const unsigned PointerAnalysis::NoNode;
+
+bool PointerAnalysis::addressEscapes(const AllocaInst *Alloca, const Instruction *Erased) {
+  for (const User *U : Alloca->users()) {
+    if (isa<LoadInst>(U) || U == Erased)
+      continue;
+    const StoreInst *Store = dyn_cast<StoreInst>(U);
+    if (!Store || Store->getValueOperand() == Alloca)
+      return true;
+  }
+  return false;
+}
+
+unsigned PointerAnalysis::number(Value *Val) {
+  // Allocas are the only sources of sites, and a load only copies from the
+  // loaded location, so every variable has at most one definition.
+  VarId Var = Index.id(Val);
+  if (NodeOf[Var] != NoNode || !isa<Instruction>(Val))
+    return NodeOf[Var];
+  if (isa<AllocaInst>(Val)) {
+    NodeOf[Var] = NumNodes++;
+  } else if (LoadInst *Load = dyn_cast<LoadInst>(Val)) {
+    unsigned Ptr = Load->getType()->isPointerTy() ? number(Load->getPointerOperand()) : NoNode;
+    if (Ptr != NoNode) {
+      auto It = LoadNodes.insert({Ptr, NumNodes});
+      if (It.second)
+        ++NumNodes;
+      NodeOf[Var] = It.first->second;
     }
-  } else if (LoadInst *Load = dyn_cast<LoadInst>(Inst)) {
+  }
+  return NodeOf[Var];
+}
+
+bool PointerAnalysis::constraintOf(Instruction &I, Constraint &C) {
+  if (AllocaInst *Alloca = dyn_cast<AllocaInst>(&I)) {
+    VarId Site = Index.id(Alloca);
+    Constrained.set(Site);
+    if (addressEscapes(Alloca))
+      Escaping.set(Site);
+    C = {Constraint::AddressOf, number(Alloca), unsigned(Sites.size())};
+    Sites.push_back(Site);
+    return true;
+  }
+  if (StoreInst *Store = dyn_cast<StoreInst>(&I)) {
+    if (!Store->getValueOperand()->getType()->isPointerTy())
+      return false;
+    VarId P = Index.id(Store->getPointerOperand());
+    Constrained.set(P);
+    Constrained.set(Index.id(Store->getValueOperand()));
+    Dereferenced.set(P);
+    C = {Constraint::Store, number(Store->getPointerOperand()), number(Store->getValueOperand())};
+    return true;
+  }
+  if (LoadInst *Load = dyn_cast<LoadInst>(&I)) {
     if (!Load->getType()->isPointerTy())
-      return;
-    std::string Variable = variable(Load->getPointerOperand());
-    PointsToSet &R = PointsTo[Variable];
-    PointsToSet &L = PointsTo[variable(Load)];
-    PointsToSet Result;
-    for (auto &I : R) {
-      PointsToSet &S = PointsTo[I];
-      std::set_union(S.begin(),
-          S.end(),
-          Result.begin(),
-          Result.end(),
-          std::inserter(Result, Result.begin()));
-    }
-    PointsTo[variable(Load)] = Result;
+      return false;
+    VarId P = Index.id(Load->getPointerOperand());
+    Constrained.set(P);
+    Constrained.set(Index.id(Load));
+    Dereferenced.set(P);
+    C = {Constraint::Load, number(Load), number(Load->getPointerOperand())};
+    return true;
   }
+  return false;
 }
 
-int PointerAnalysis::countFacts(PointsToInfo &PointsTo) {
-  int N = 0;
-  for (auto &I : PointsTo)
-    N += I.second.size();
-  return N;
+std::vector<PointerAnalysis::Constraint> PointerAnalysis::collectConstraints(Function &F) {
+  NodeOf.assign(Index.size(), NoNode);
+  std::vector<Constraint> Constraints;
+  DenseSet<std::pair<unsigned, unsigned>> Loads;
+  DenseSet<std::pair<unsigned, unsigned>> Stores;
+  for (Instruction &I : instructions(F)) {
+    Constraint C;
+    if (!constraintOf(I, C))
+      continue;
+    ++ConstraintsBefore;
+    if (C.Dst == NoNode || C.Src == NoNode)
+      continue;
+    if (C.Kind == Constraint::Load && !Loads.insert({C.Dst, C.Src}).second)
+      continue;
+    if (C.Kind == Constraint::Store && !Stores.insert({C.Dst, C.Src}).second)
+      continue;
+    Constraints.push_back(C);
+  }
+
+  VarsBefore = Constrained.count();
+  ConstraintsAfter = Constraints.size();
+  return Constraints;
 }
 
-void PointerAnalysis::print(std::map<std::string, PointsToSet> &PointsTo) {
-  errs() << "Pointer Analysis Results:\n";
-  for (auto &I : PointsTo) {
-    errs() << "  " << I.first << ": { ";
-    for (auto &J : I.second) {
-      errs() << J << "; ";
-    }
-    errs() << "}\n";
+void PointerAnalysis::finish() {
+  // Every site is an alloca, which points to itself only, so the allocas
+  // aliased by a pointer are the sites it points to. Sites are numbered in
+  // layout order, as are their IDs, so each row is sorted. Nodes with the
+  // same points-to set share its row.
+  RowOf.resize(NumNodes);
+  for (unsigned N = 0; N < NumNodes; ++N)
+    RowOf[N] = row(pointsToNode(N));
+}
+
+void PointerAnalysis::finish(ArrayRef<unsigned> Changed) {
+  RowOf.resize(NumNodes, row(Cache.empty()));
+  for (unsigned N : Changed)
+    RowOf[N] = row(pointsToNode(N));
+}
+
+unsigned PointerAnalysis::row(SetRef Pts) {
+  auto It = Rows.insert({Pts, AliasTable.size()});
+  if (It.second) {
+    AliasTable.emplace_back();
+    for (unsigned Site : *Pts)
+      AliasTable.back().push_back(Sites[Site]);
   }
-  errs() << "\n";
+  return It.first->second;
 }
 
-PointerAnalysis::PointerAnalysis(Function &F) {
-  int NumOfOldFacts = 0;
-  int NumOfNewFacts = 0;
+void PointerAnalysis::printStats(raw_ostream &OS) const {
+  OS << VarsBefore << " -> " << NumNodes << " pointer nodes, " << ConstraintsBefore
+     << " -> " << ConstraintsAfter << " constraints, " << AliasTable.size()
+     << " distinct points-to sets";
+}
 
-  while (true) {
-    for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
-      auto Inst = &*Iter;
-      transfer(Inst, PointsTo);
+void PointerAnalysis::print(raw_ostream &OS) {
+  // Every site and every distinct set is printed to a string once.
+  std::vector<std::string> SiteNames(Sites.size());
+  for (unsigned Site = 0; Site < Sites.size(); ++Site)
+    SiteNames[Site] = address(Index.value(Sites[Site]));
+  DenseMap<SetRef, std::string> Printed;
+  auto PrintSet = [&](SetRef S) {
+    auto It = Printed.insert({S, std::string()});
+    if (It.second) {
+      raw_string_ostream SS(It.first->second);
+      SS << "{ ";
+      for (unsigned Site : *S)
+        SS << SiteNames[Site] << "; ";
+      SS << "}\n";
     }
-    NumOfNewFacts = countFacts(PointsTo);
-    if (NumOfOldFacts < NumOfNewFacts)
-      NumOfOldFacts = NumOfNewFacts;
-    else
-      break;
+    OS << It.first->second;
+  };
+
+  // Only the sites loaded or stored through have contents.
+  SetRef Accessed = Cache.empty();
+  for (unsigned Var : Dereferenced.set_bits())
+    Accessed = Cache.unite(Accessed, pointsTo(Var));
+
+  OS << "Pointer Analysis Results:\n";
+  for (unsigned Var : Constrained.set_bits()) {
+    OS << "  " << Index.name(Var) << ": ";
+    PrintSet(pointsTo(Var));
+  }
+  for (unsigned Site : *Accessed) {
+    OS << "  " << SiteNames[Site] << ": ";
+    PrintSet(contents(Site));
   }
-  print(PointsTo);
+  OS << "\n";
 }
 
-bool PointerAnalysis::alias(std::string &Ptr1, std::string &Ptr2) const {
-  if (PointsTo.find(Ptr1) == PointsTo.end() || PointsTo.find(Ptr2) == PointsTo.end())
-    return false;
-  const PointsToSet &S1 = PointsTo.at(Ptr1);
-  const PointsToSet &S2 = PointsTo.at(Ptr2);
+PointerAnalysis::SetRef PointerAnalysis::pointsTo(VarId Var) const {
+  return NodeOf[Var] == NoNode ? Cache.empty() : pointsToNode(NodeOf[Var]);
+}
+
+const std::vector<VarId> &PointerAnalysis::aliasedAllocas(VarId Ptr) const {
+  return NodeOf[Ptr] == NoNode ? NoAliases : AliasTable[RowOf[NodeOf[Ptr]]];
+}
+
+bool PointerAnalysis::alias(VarId Ptr1, VarId Ptr2) const {
+  // Equal sets are the same set.
+  SetRef Pts1 = pointsTo(Ptr1);
+  SetRef Pts2 = pointsTo(Ptr2);
+  if (Pts1 == Pts2)
+    return Pts1 != Cache.empty();
+  return Pts1->intersects(*Pts2);
+}
+
+AnalysisKey PointerAnalysisPass::Key;
+
+PointerAnalysis &PointerAnalysisResult::get(PointerMode Mode, unsigned Threads) {
+  assert(Mode != PointerMode::Auto && "auto is resolved by the client");
+  std::unique_ptr<PointerAnalysis> &PA = Analyses[unsigned(Mode)];
+  if (PA)
+    return *PA;
+  if (Mode == PointerMode::Steensgaard)
+    PA = std::make_unique<SteensgaardAnalysis>(*Func, *Index);
+  else if (Mode == PointerMode::FlowSensitive)
+    PA = std::make_unique<FlowSensitiveAnalysis>(*Func, *Index, get(PointerMode::Andersen, Threads));
+  else
+    PA = std::make_unique<AndersenAnalysis>(*Func, *Index, Threads);
+  return *PA;
+}
 
-  PointsToSet Inter;
-  std::set_intersection(
-      S1.begin(), S1.end(), S2.begin(), S2.end(), std::inserter(Inter, Inter.begin()));
-  return !Inter.empty();
+bool PointerAnalysisResult::invalidate(
+    Function &, const PreservedAnalyses &PA, FunctionAnalysisManager::Invalidator &) {
+  auto Checker = PA.getChecker<PointerAnalysisPass>();
+  return !Checker.preserved() && !Checker.preservedSet<AllAnalysesOn<Function>>();
 }
 
-};  // namespace dataflow
+}  // namespace dataflow
@@ -0,0 +1,81 @@
+#include "PointsToCache.h"
+
+#include "llvm/ADT/Hashing.h"
+
+#include <functional>
+
+namespace dataflow {
+
+size_t PointsToCache::SetHash::operator()(const PointsToSet &S) const {
+  hash_code Hash = hash_value(S.count());
+  for (unsigned Site : S)
+    Hash = hash_combine(Hash, Site);
+  return Hash;
+}
+
+PointsToCache::PointsToCache() : Empty(&*Sets.insert(PointsToSet()).first) {}
+
+PointsToCache::SetRef PointsToCache::internLocked(const PointsToSet &S) {
+  return &*Sets.insert(S).first;
+}
+
+PointsToCache::SetRef PointsToCache::intern(const PointsToSet &S) {
+  if (S.empty())
+    return Empty;
+  std::lock_guard<std::mutex> Guard(Lock);
+  return internLocked(S);
+}
+
+template <typename OpTy>
+PointsToCache::SetRef PointsToCache::memoize(
+    DenseMap<Operands, SetRef> &Memo, SetRef A, SetRef B, OpTy Op) {
+  {
+    std::lock_guard<std::mutex> Guard(Lock);
+    auto It = Memo.find({A, B});
+    if (It != Memo.end())
+      return It->second;
+  }
+  PointsToSet Result = *A;
+  Op(Result, *B);
+  std::lock_guard<std::mutex> Guard(Lock);
+  SetRef Ref = internLocked(Result);
+  Memo[{A, B}] = Ref;
+  return Ref;
+}
+
+PointsToCache::SetRef PointsToCache::unite(SetRef A, SetRef B) {
+  if (A == B || B == Empty)
+    return A;
+  if (A == Empty)
+    return B;
+  // Union is symmetric, so the operands are ordered to share the entry.
+  if (std::less<SetRef>()(B, A))
+    std::swap(A, B);
+  return memoize(Unions, A, B, [](PointsToSet &R, const PointsToSet &S) { R |= S; });
+}
+
+PointsToCache::SetRef PointsToCache::subtract(SetRef A, SetRef B) {
+  if (A == B || A == Empty)
+    return Empty;
+  if (B == Empty)
+    return A;
+  return memoize(Differences, A, B,
+      [](PointsToSet &R, const PointsToSet &S) { R.intersectWithComplement(S); });
+}
+
+PointsToCache::SetRef PointsToCache::intersect(SetRef A, SetRef B) {
+  if (A == B)
+    return A;
+  if (A == Empty || B == Empty)
+    return Empty;
+  if (std::less<SetRef>()(B, A))
+    std::swap(A, B);
+  return memoize(Intersections, A, B, [](PointsToSet &R, const PointsToSet &S) { R &= S; });
+}
+
+size_t PointsToCache::size() const {
+  std::lock_guard<std::mutex> Guard(Lock);
+  return Sets.size();
+}
+
+}  // namespace dataflow
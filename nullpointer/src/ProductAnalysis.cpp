@@ -0,0 +1,199 @@
+#include "ProductAnalysis.h"
+
+#include "ParallelDriver.h"
+
+namespace dataflow {
+
+//===----------------------------------------------------------------------===//
+// Product Analysis Implementation
+//===----------------------------------------------------------------------===//
+
+void ProductAnalysis::transfer(Instruction *I, const ProductMemory *In, ProductMemory &NOut) {
+  auto *Call = dyn_cast<CallInst>(I);
+  if (Call && Summaries && Options.Contexts) {
+    CallContext Context;
+    Null.addArguments(Call, &In->Null, Context);
+    Zero.addArguments(Call, &In->Zero, Context);
+    Ovf.addArguments(Call, &In->Ovf, Context);
+    if (const FunctionSummary *Summary = Summaries->lookup(*Call, Context, Slots)) {
+      Null.applySummary(Call, *Summary, &In->Null, NOut.Null);
+      Zero.applySummary(Call, *Summary, &In->Zero, NOut.Zero);
+      Ovf.applySummary(Call, *Summary, &In->Ovf, NOut.Ovf);
+      return;
+    }
+  }
+  Null.transfer(I, &In->Null, NOut.Null);
+  Zero.transfer(I, &In->Zero, NOut.Zero);
+  Ovf.transfer(I, &In->Ovf, NOut.Ovf);
+}
+
+void ProductAnalysis::entry(ProductMemory &InMem) {
+  Null.entry(InMem.Null);
+  Zero.entry(InMem.Zero);
+  Ovf.entry(InMem.Ovf);
+}
+
+bool ProductAnalysis::edge(unsigned Pred, unsigned B, ProductMemory &Mem) {
+  return Null.edge(Pred, B, Mem.Null) && Zero.edge(Pred, B, Mem.Zero) &&
+         Ovf.edge(Pred, B, Mem.Ovf);
+}
+
+PreservedAnalyses ProductAnalysis::run(Function &F, FunctionAnalysisManager &FAM) {
+  setup(F, FAM);
+  analyze(F);
+  report(F, outs());
+  return PreservedAnalyses::all();
+}
+
+void ProductAnalysis::setup(Function &F, FunctionAnalysisManager &FAM) {
+  // Number F once for the three analyses. The values are numbered by the
+  // pointer analyses of F, so that the alias queries of NullPtr take the same
+  // IDs.
+  Shared = &FAM.getResult<PointerAnalysisPass>(F);
+  Blocks = std::make_unique<FunctionIndex>(F);
+  WTO = std::make_unique<WeakTopologicalOrder>(*Blocks);
+  Null.Index = Zero.Index = Ovf.Index = &Shared->index();
+  Null.Graph = Zero.Graph = Ovf.Graph = Blocks.get();
+  Ovf.prepare(F, FAM);
+}
+
+void ProductAnalysis::analyze(Function &F) {
+  Null.ErrorInsts.clear();
+  Ovf.ErrorInsts.clear();
+  Zero.ErrorInsts.clear();
+  Null.Log = Ovf.Log = Zero.Log = Log;
+  Null.Summaries = Ovf.Summaries = Zero.Summaries = Summaries;
+  PointerMode Mode = Null.pointerMode(F);
+  Null.Pointers = &Shared->get(Mode, Options.PointerThreads);
+  Slots.clear();
+
+  // The intervals need widening, so the product is iterated like Overflow;
+  // the Domain components reach the same fixpoint as by chaotic iteration.
+  Fixpoint = std::make_unique<Engine>(*Blocks, ProductLattice{{}, {&Ovf.Thresholds}}, *this);
+  Null.Reached = Zero.Reached = Ovf.Reached = [this](unsigned B) {
+    return Fixpoint->evaluated(B);
+  };
+  Fixpoint->solve(RecursiveIteration(*WTO, Ovf.WideningDelays, Options.NarrowIterations));
+
+  auto NullIn = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N).Null; };
+  auto ZeroIn = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N).Zero; };
+  auto OvfOut = [this](unsigned N) -> const OverflowMemory & {
+    return Fixpoint->outState(N).Ovf;
+  };
+  for (inst_iterator Iter = inst_begin(F), End = inst_end(F); Iter != End; ++Iter) {
+    auto Inst = &(*Iter);
+    if (Null.check(Inst, NullIn))
+      Null.ErrorInsts.insert(Inst);
+    if (Ovf.check(Inst, OvfOut))
+      Ovf.ErrorInsts.insert(Inst);
+    if (Zero.check(Inst, ZeroIn))
+      Zero.ErrorInsts.insert(Inst);
+  }
+
+  if (Summaries) {
+    FunctionSummary &Summary = Summaries->summary(F);
+    Null.summarize(F, NullIn, Null.ErrorInsts, Summary);
+    Ovf.summarize(F, OvfOut, Summary);
+    Zero.summarize(F, ZeroIn, Summary);
+  }
+
+  if (Options.Stats) {
+    *Log << getAnalysisName() << " stats for " << F.getName() << ": "
+         << Fixpoint->blockVisits() << " block visits, " << Fixpoint->instVisits()
+         << " instruction visits (" << Blocks->blocks() << " blocks, " << Blocks->size()
+         << " instructions, " << pointerModeName(Mode) << " pointer analysis)\n";
+  }
+
+  Fixpoint.reset();
+}
+
+FunctionSummary ProductAnalysis::analyzeContext(Function &F, const CallContext &Context) {
+  // The diagnostics of F were printed by analyze().
+  Null.Log = Ovf.Log = Zero.Log = &nulls();
+  Null.EntryContext = Zero.EntryContext = Ovf.EntryContext = &Context;
+  Slots.clear();
+  Fixpoint = std::make_unique<Engine>(*Blocks, ProductLattice{{}, {&Ovf.Thresholds}}, *this);
+  Fixpoint->solve(RecursiveIteration(*WTO, Ovf.WideningDelays, Options.NarrowIterations));
+
+  auto NullIn = [this](unsigned N) -> const Memory & { return Fixpoint->inState(N).Null; };
+  SetVector<Instruction *> Flagged;
+  for (Instruction &Inst : instructions(F)) {
+    if (Null.check(&Inst, NullIn))
+      Flagged.insert(&Inst);
+  }
+  FunctionSummary Summary;
+  Null.summarize(F, NullIn, Flagged, Summary);
+  Ovf.summarize(F, [this](unsigned N) -> const OverflowMemory & {
+    return Fixpoint->outState(N).Ovf;
+  }, Summary);
+  Zero.summarize(F, [this](unsigned N) -> const Memory & {
+    return Fixpoint->inState(N).Zero;
+  }, Summary);
+
+  Fixpoint.reset();
+  Null.EntryContext = Zero.EntryContext = Ovf.EntryContext = nullptr;
+  Null.Log = Ovf.Log = Zero.Log = Log;
+  return Summary;
+}
+
+void ProductAnalysis::report(Function &F, raw_ostream &Out) {
+  if (Options.Stats && Options.Contexts) {
+    *Log << getAnalysisName() << " contexts for " << F.getName() << ": ";
+    Summaries->printContexts(*Log, F);
+    *Log << "\n";
+  }
+  Out << "Running " << getAnalysisName() << " on " << F.getName() << "\n";
+  Out << "Potential Instructions by " << Null.getAnalysisName() << ": \n";
+  for (auto Inst : Null.ErrorInsts)
+    Out << *Inst << "\n";
+  Out << "Potential Overflow Instructions by " << Ovf.getAnalysisName() << ":\n";
+  for (auto Inst : Ovf.ErrorInsts)
+    Out << *Inst << "\n";
+  Out << "Potential Instructions by " << Zero.getAnalysisName() << ": \n";
+  for (auto Inst : Zero.ErrorInsts)
+    Out << *Inst << "\n";
+}
+
+/**
+ * @brief Entry point of the combined plugin, which overrides the weak ones of
+ * the analyses it links and registers all of their passes.
+ */
+extern "C" ::llvm::PassPluginLibraryInfo llvmGetPassPluginInfo() {
+  return {LLVM_PLUGIN_API_VERSION, "Dataflow", "v0.1", [](PassBuilder &PB) {
+            PB.registerAnalysisRegistrationCallback([](FunctionAnalysisManager &FAM) {
+              FAM.registerPass([] { return PointerAnalysisPass(); });
+            });
+            PB.registerPipelineParsingCallback(
+                [](StringRef Name,
+                    ModulePassManager &MPM,
+                    ArrayRef<PassBuilder::PipelineElement>) {
+                  DataflowOptions Options;
+                  if (parsePassName(Name, "NullPtr", Options)) {
+                    MPM.addPass(ParallelDriver<NullPointerAnalysis>(Options));
+                    return true;
+                  }
+                  if (parsePassName(Name, "Overflow", Options)) {
+                    MPM.addPass(ParallelDriver<OverflowAnalysis>(Options));
+                    return true;
+                  }
+                  if (parsePassName(Name, "DivZero", Options)) {
+                    MPM.addPass(ParallelDriver<DivZeroAnalysis>(Options));
+                    return true;
+                  }
+                  if (!parsePassName(Name, "Dataflow", Options))
+                    return false;
+                  // The points-to sets, pointer comparisons and edit timings are
+                  // NullPtr reports.
+                  if (Options.PrintPointers || Options.ComparePointers || Options.TimeEdits) {
+                    StringRef Option = Options.PrintPointers ? "print-pointers"
+                        : Options.ComparePointers            ? "compare-pointers"
+                                                             : "time-edits";
+                    errs() << "Invalid Dataflow option: " << Option << "\n";
+                    return false;
+                  }
+                  MPM.addPass(ParallelDriver<ProductAnalysis>(Options));
+                  return true;
+                });
+          }};
+}
+}  // namespace dataflow
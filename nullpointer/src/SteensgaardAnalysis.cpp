@@ -0,0 +1,100 @@
+#include "SteensgaardAnalysis.h"
+
+#include <utility>
+
+namespace dataflow {
+
+unsigned SteensgaardAnalysis::addNode() {
+  unsigned N = Parent.size();
+  Parent.push_back(N);
+  Rank.push_back(0);
+  Pointee.push_back(NoNode);
+  return N;
+}
+
+unsigned SteensgaardAnalysis::find(unsigned N) {
+  while (Parent[N] != N) {
+    Parent[N] = Parent[Parent[N]];
+    N = Parent[N];
+  }
+  return N;
+}
+
+unsigned SteensgaardAnalysis::pointee(unsigned N) {
+  N = find(N);
+  if (Pointee[N] == NoNode) {
+    unsigned Fresh = addNode();
+    Pointee[N] = Fresh;
+  }
+  return Pointee[N];
+}
+
+void SteensgaardAnalysis::unify(unsigned A, unsigned B) {
+  // Unifying two classes unifies their pointees, and so on down; a worklist
+  // keeps long pointer chains off the call stack.
+  std::vector<std::pair<unsigned, unsigned>> Pending = {{A, B}};
+  while (!Pending.empty()) {
+    unsigned X = find(Pending.back().first);
+    unsigned Y = find(Pending.back().second);
+    Pending.pop_back();
+    if (X == Y)
+      continue;
+    if (Rank[X] < Rank[Y])
+      std::swap(X, Y);
+    Parent[Y] = X;
+    if (Rank[X] == Rank[Y])
+      ++Rank[X];
+    if (Pointee[X] == NoNode)
+      Pointee[X] = Pointee[Y];
+    else if (Pointee[Y] != NoNode)
+      Pending.push_back({Pointee[X], Pointee[Y]});
+  }
+}
+
+PointerAnalysis::SetRef SteensgaardAnalysis::sitesPointedBy(unsigned N) const {
+  unsigned P = Pointee[Parent[N]];
+  return P == NoNode ? Cache.empty() : ClassSites[Parent[P]];
+}
+
+SteensgaardAnalysis::SteensgaardAnalysis(Function &F, const ValueIndex &Index)
+    : PointerAnalysis(Index) {
+  std::vector<Constraint> Constraints = collectConstraints(F);
+  for (unsigned N = 0; N < NumNodes + Sites.size(); ++N)
+    addNode();
+
+  for (const Constraint &C : Constraints) {
+    switch (C.Kind) {
+    case Constraint::AddressOf: {
+      unsigned Target = pointee(C.Dst);
+      unify(Target, NumNodes + C.Src);
+      break;
+    }
+    case Constraint::Load: {
+      unsigned Target = pointee(C.Dst);
+      unsigned Loaded = pointee(pointee(C.Src));
+      unify(Target, Loaded);
+      break;
+    }
+    case Constraint::Store: {
+      unsigned Target = pointee(pointee(C.Dst));
+      unsigned Stored = pointee(C.Src);
+      unify(Target, Stored);
+      break;
+    }
+    }
+  }
+
+  // Flatten the classes so that the queries can read them without find().
+  for (unsigned N = 0; N < Parent.size(); ++N)
+    Parent[N] = find(N);
+  std::vector<PointsToSet> Members(Parent.size());
+  for (unsigned Site = 0; Site < Sites.size(); ++Site)
+    Members[Parent[NumNodes + Site]].set(Site);
+  ClassSites.resize(Parent.size());
+  for (unsigned N = 0; N < Parent.size(); ++N)
+    ClassSites[N] = Cache.intern(Members[N]);
+
+  finish();
+}
+
+}  // namespace dataflow
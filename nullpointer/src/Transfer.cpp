@@ -24,17 +24,18 @@ bool isInput(Instruction *Inst) {
  *
  * @param Phi PHINode to evaluate
  * @param InMem InMemory of Phi
+ * @param Index Value numbering the keys of InMem
  * @return Domain of Phi
  */
-Domain *eval(PHINode *Phi, const Memory *InMem) {
+Domain eval(PHINode *Phi, const Memory *InMem, const ValueIndex &Index) {
   if (auto ConstantVal = Phi->hasConstantValue()) {
-    return new Domain(extractFromValue(ConstantVal));
+    return Domain(extractFromValue(ConstantVal));
   }
 
-  Domain *Joined = new Domain(Domain::Uninit);
+  Domain Joined(Domain::Uninit);
 
   for (unsigned int i = 0; i < Phi->getNumIncomingValues(); i++) {
-    auto Dom = getOrExtract(InMem, Phi->getIncomingValue(i));
+    auto Dom = getOrExtract(InMem, Index, Phi->getIncomingValue(i));
     Joined = Domain::join(Joined, Dom);
   }
   return Joined;
@@ -45,37 +46,35 @@ Domain *eval(PHINode *Phi, const Memory *InMem) {
  *
  * @param Cast Cast instruction to evaluate
  * @param InMem InMemory of Instruction
+ * @param Index Value numbering the keys of InMem
  * @return Domain of Cast
  */
-Domain *eval(CastInst *Cast, const Memory *InMem) {
+Domain eval(CastInst *Cast, const Memory *InMem, const ValueIndex &Index) {
   /**
    * TODO: Write your code here to evaluate Cast instruction.
    */
   Value *Operand = Cast->getOperand(0);
-  Domain *OpDomain = getOrExtract(InMem, Operand);
-
-  return new Domain(*OpDomain);
+  return getOrExtract(InMem, Index, Operand);
 }
 
 void NullPointerAnalysis::transfer(Instruction *Inst,
     const Memory *In,
-    Memory &NOut,
-    PointerAnalysis *PA,
-    SetVector<Value *> PointerSet) {
+    Memory &NOut) {
+  const PointerAnalysis &PA = *Pointers;
   if (auto Phi = dyn_cast<PHINode>(Inst)) {
     // Evaluate PHI node
-    NOut[variable(Phi)] = eval(Phi, In);
+    NOut.set(Index->id(Phi), eval(Phi, In, *Index));
   } else if (auto BinOp = dyn_cast<BinaryOperator>(Inst)) {
     // Evaluate BinaryOperator
-    // NOut[variable(BinOp)] = eval(BinOp, In);
+    // NOut[Index->id(BinOp)] = eval(BinOp, In, *Index);
   } else if (auto Cast = dyn_cast<CastInst>(Inst)) {
     // Evaluate Cast instruction
-    NOut[variable(Cast)] = eval(Cast, In);
+    NOut.set(Index->id(Cast), eval(Cast, In, *Index));
   } else if (auto Cmp = dyn_cast<CmpInst>(Inst)) {
     // Evaluate Comparision instruction
-    // NOut[variable(Cmp)] = eval(Cmp, In);
+    // NOut[Index->id(Cmp)] = eval(Cmp, In, *Index);
   } else if (auto Alloca = dyn_cast<AllocaInst>(Inst)) {
-    NOut[variable(Alloca)] = new Domain(Domain::NonNull);
+    NOut.set(Index->id(Alloca), Domain(Domain::NonNull));
   } else if (auto Store = dyn_cast<StoreInst>(Inst)) {
 
     auto *Ptr = Store->getPointerOperand();
@@ -83,36 +82,27 @@ void NullPointerAnalysis::transfer(Instruction *Inst,
 
     if (!Val->getType()->isPointerTy()) return;
 
-    std::string PtrName = variable(Ptr);
+    VarId PtrName = Index->id(Ptr);
     
     // Allocas are nonnull
-    Domain *ValDom = nullptr;
+    Domain ValDom;
     if (isa<AllocaInst>(Val->stripPointerCasts())) {
-        ValDom = new Domain(Domain::NonNull);
+        ValDom = Domain(Domain::NonNull);
     } else {
-        ValDom = getOrExtract(In, Val);
+        ValDom = getOrExtract(In, *Index, Val);
     }
 
     // Identify all aliases
-    std::vector<std::string> Aliases;
-
-    for (auto *P : PointerSet) {
-      if (isa<AllocaInst>(P)) {
-        std::string AliasName = variable(P);
-        if (PA->alias(PtrName, AliasName)) {
-           Aliases.push_back(AliasName);
-        }
-      }
-    }
+    const std::vector<VarId> &Aliases = PA.aliasedAllocas(PtrName);
 
     if (Aliases.size() == 1) {
        // Directly assign if only 1 alias
-       NOut[Aliases[0]] = ValDom;
+       NOut.set(Aliases[0], ValDom);
     } else {
        // Join with old values
        for (const auto &Alias : Aliases) {
-          Domain *OldVal = In->count(Alias) ? In->at(Alias) : new Domain(Domain::Uninit);
-          NOut[Alias] = Domain::join(OldVal, ValDom);
+          const Domain *OldVal = In->find(Alias);
+          NOut.set(Alias, Domain::join(OldVal ? *OldVal : Domain(Domain::Uninit), ValDom));
        }
     }
 
@@ -121,38 +111,36 @@ void NullPointerAnalysis::transfer(Instruction *Inst,
     if (!Load->getType()->isPointerTy()) return;
 
     Value *Ptr = Load->getPointerOperand();
-    std::string PtrName = variable(Ptr);
-    std::string DestName = variable(Load);
+    VarId PtrName = Index->id(Ptr);
+    VarId DestName = Index->id(Load);
 
-    Domain *Loaded = new Domain(Domain::Uninit);
+    Domain Loaded(Domain::Uninit);
 
     // Join domain values from all aliases
-    for (auto *P : PointerSet) {
-        if (isa<AllocaInst>(P)) {
-            std::string Key = variable(P);
-            if (PA->alias(PtrName, Key)) {
-                if (In->count(Key)) {
-                     Loaded = Domain::join(Loaded, In->at(Key));
-                }
-            }
+    for (VarId Key : PA.aliasedAllocas(PtrName)) {
+        if (const Domain *KeyDom = In->find(Key)) {
+             Loaded = Domain::join(Loaded, *KeyDom);
         }
     }
     
     // Fallback if Uninit
-    if (Domain::equal(*Loaded, Domain::Uninit)) {
-        NOut[DestName] = new Domain(Domain::MaybeNull);
+    if (Domain::equal(Loaded, Domain::Uninit)) {
+        NOut.set(DestName, Domain(Domain::MaybeNull));
     } else {
-        NOut[DestName] = Loaded;
+        NOut.set(DestName, Loaded);
     }
 
   } else if (auto Branch = dyn_cast<BranchInst>(Inst)) {
     // Analysis is flow-insensitive, so do nothing here.
   } else if (auto Call = dyn_cast<CallInst>(Inst)) {
-    // Analysis is intra-procedural, so do nothing here.
+    // The pointer returned is as null as the summary of the callee says;
+    // without a summary the analysis is intra-procedural.
+    if (const FunctionSummary *Summary = callSummary(Call, In))
+      applySummary(Call, *Summary, In, NOut);
   } else if (auto Return = dyn_cast<ReturnInst>(Inst)) {
-    // Analysis is intra-procedural, so do nothing here.
+    // Returned values are summarized from the fixpoint, so do nothing here.
   } else {
-    errs() << "Unhandled instruction: " << *Inst << "\n";
+    *Log << "Unhandled instruction: " << *Inst << "\n";
   }
 }
 
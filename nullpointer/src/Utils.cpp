@@ -6,15 +6,6 @@
 const char *WHITESPACES = " \t\n\r";
 const size_t VARIABLE_PADDED_LEN = 8;
 
-template <typename V, typename K, class Map, class DefaultConstructor>
-V getOrDefault(const Map *M, const K &Key, DefaultConstructor Default) {
-  const auto It = M->find(Key);
-  if (It == M->end())
-    return Default();
-
-  return It->second;
-}
-
 namespace dataflow {
 
 std::string variable(const Value *Val) {
@@ -51,42 +42,47 @@ Domain::Element extractFromValue(const Value *Val) {
   return Domain::Uninit;
 }
 
-Domain *getOrExtract(const Memory *Mem, const Value *Val) {
-  return getOrDefault<Domain *>(
-      Mem, variable(Val), [&V = Val] { return new Domain(extractFromValue(V)); });
+Domain getOrExtract(const Memory *Mem, const ValueIndex &Index, const Value *Val) {
+  const Domain *Dom = Mem->find(Index.lookup(Val));
+  if (!Dom)
+    return Domain(extractFromValue(Val));
+
+  return *Dom;
 }
 
-void printMemory(const Memory *Mem) {
-  for (auto Iter = Mem->begin(), End = Mem->end(); Iter != End; ++Iter) {
-    errs() << "    [ " << Iter->first << " |-> " << *Iter->second << " ]\n";
-  }
+void printMemory(raw_ostream &OS, const Memory *Mem, const ValueIndex &Index) {
+  Mem->forEach([&](VarId Var, Domain Dom) {
+    OS << "    [ " << Index.name(Var) << " |-> " << Dom << " ]\n";
+  });
   if (Mem->empty()) {
-    errs() << "\n";
+    OS << "\n";
   }
 }
 
-void printInstructionTransfer(
-    Instruction *Inst, const Memory *InMem, const Memory *OutMem) {
-  auto InState = getOrExtract(InMem, Inst);
-  auto OutState = getOrExtract(OutMem, Inst);
+void printInstructionTransfer(raw_ostream &OS,
+    Instruction *Inst,
+    const Memory *InMem,
+    const Memory *OutMem,
+    const ValueIndex &Index) {
+  auto InState = getOrExtract(InMem, Index, Inst);
+  auto OutState = getOrExtract(OutMem, Index, Inst);
 
-  errs() << variable(Inst) << ":\t[ " << *InState << " --> " << *OutState << " ]\n";
+  OS << variable(Inst) << ":\t[ " << InState << " --> " << OutState << " ]\n";
 }
 
-void printMap(Function &F,
-    std::map<Instruction *, Memory *> &InMap,
-    std::map<Instruction *, Memory *> &OutMap) {
-  errs() << "Dataflow Analysis Results:\n";
-  for (inst_iterator Iter = inst_begin(F), E = inst_end(F); Iter != E; ++Iter) {
-    auto Inst = &(*Iter);
-    errs() << "Instruction: " << *Inst << "\n";
-    errs() << "In set: \n";
-    auto InMem = InMap[Inst];
-    printMemory(InMem);
-    errs() << "Out set: \n";
-    auto OutMem = OutMap[Inst];
-    printMemory(OutMem);
-    errs() << "\n";
+void printMap(raw_ostream &OS,
+    const FunctionIndex &Graph,
+    function_ref<const Memory &(unsigned)> InState,
+    function_ref<const Memory &(unsigned)> OutState,
+    const ValueIndex &Index) {
+  OS << "Dataflow Analysis Results:\n";
+  for (unsigned N = 0; N < Graph.size(); ++N) {
+    OS << "Instruction: " << *Graph.instruction(N) << "\n";
+    OS << "In set: \n";
+    printMemory(OS, &InState(N), Index);
+    OS << "Out set: \n";
+    printMemory(OS, &OutState(N), Index);
+    OS << "\n";
   }
 }
 
@@ -0,0 +1,65 @@
+#include "ValueIndex.h"
+
+#include "Utils.h"
+
+#include "llvm/IR/InstIterator.h"
+
+#include <cassert>
+
+namespace dataflow {
+
+ValueIndex::ValueIndex(Function &F) {
+  for (Argument &Arg : F.args())
+    insert(&Arg);
+  for (Instruction &I : instructions(F))
+    insert(&I);
+  // Constants and globals come last so that arguments and instructions keep
+  // the small IDs.
+  for (Instruction &I : instructions(F)) {
+    for (Use &U : I.operands()) {
+      if (!isa<BasicBlock>(U.get()))
+        insert(U.get());
+    }
+  }
+}
+
+void ValueIndex::insert(const Value *Val) {
+  if (Ids.try_emplace(Val, Values.size()).second)
+    Values.push_back(Val);
+}
+
+VarId ValueIndex::add(const Value *Val) {
+  insert(Val);
+  return Ids.lookup(Val);
+}
+
+void ValueIndex::remove(const Value *Val) {
+  auto It = Ids.find(Val);
+  if (It == Ids.end())
+    return;
+  Values[It->second] = nullptr;
+  Ids.erase(It);
+}
+
+VarId ValueIndex::id(const Value *Val) const {
+  auto It = Ids.find(Val);
+  assert(It != Ids.end() && "value does not belong to the function");
+  return It->second;
+}
+
+const std::string &ValueIndex::name(VarId Id) const {
+  if (Names.size() < Values.size())
+    Names.resize(Values.size());
+  if (Names[Id].empty())
+    Names[Id] = variable(Values[Id]);
+  return Names[Id];
+}
+
+VarId ValueIndex::lookup(const Value *Val) const {
+  auto It = Ids.find(Val);
+  if (It == Ids.end())
+    return NoVar;
+  return It->second;
+}
+
+}  // namespace dataflow
@@ -0,0 +1,107 @@
+#include "WeakTopologicalOrder.h"
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+
+namespace dataflow {
+
+namespace {
+
+// A block, or a component made of a head block and a body.
+struct Element {
+  unsigned Block;
+  bool IsComponent;
+  std::vector<Element> Body;
+};
+
+// Bourdoncle's algorithm ("Efficient chaotic iteration strategies with
+// widenings", 1993). Partitions are built back to front and reversed once
+// they are complete.
+class Builder {
+ public:
+  Builder(const FunctionIndex &Graph)
+      : Graph(Graph), DFN(Graph.blocks(), 0) {}
+
+  std::vector<Element> run() {
+    std::vector<Element> Partition;
+    visit(0, Partition);
+    std::reverse(Partition.begin(), Partition.end());
+    return Partition;
+  }
+
+ private:
+  const FunctionIndex &Graph;
+  std::vector<unsigned> DFN;
+  std::vector<unsigned> Stack;
+  unsigned Num = 0;
+
+  unsigned visit(unsigned V, std::vector<Element> &Partition) {
+    Stack.push_back(V);
+    DFN[V] = ++Num;
+    unsigned Head = DFN[V];
+    bool Loop = false;
+
+    for (unsigned W : Graph.blockSuccessors(V)) {
+      unsigned Min = DFN[W] == 0 ? visit(W, Partition) : DFN[W];
+      if (Min <= Head) {
+        Head = Min;
+        Loop = true;
+      }
+    }
+
+    if (Head == DFN[V]) {
+      DFN[V] = UINT_MAX;
+      unsigned Top = Stack.back();
+      Stack.pop_back();
+      if (Loop) {
+        while (Top != V) {
+          DFN[Top] = 0;
+          Top = Stack.back();
+          Stack.pop_back();
+        }
+        Partition.push_back(component(V));
+      } else {
+        Partition.push_back(Element{V, false, {}});
+      }
+    }
+    return Head;
+  }
+
+  Element component(unsigned V) {
+    std::vector<Element> Body;
+    for (unsigned W : Graph.blockSuccessors(V)) {
+      if (DFN[W] == 0)
+        visit(W, Body);
+    }
+    std::reverse(Body.begin(), Body.end());
+    return Element{V, true, std::move(Body)};
+  }
+};
+
+}  // namespace
+
+WeakTopologicalOrder::WeakTopologicalOrder(const FunctionIndex &Graph)
+    : HeadBlocks(Graph.blocks(), false) {
+  if (Graph.blocks() == 0)
+    return;
+
+  // Lay the nested partitions out flat, depth first.
+  std::function<void(const std::vector<Element> &)> Flatten =
+      [&](const std::vector<Element> &Partition) {
+        for (const Element &E : Partition) {
+          unsigned I = Order.size();
+          Order.push_back(E.Block);
+          Heads.push_back(E.IsComponent);
+          End.push_back(I + 1);
+          if (E.IsComponent) {
+            HeadBlocks[E.Block] = true;
+            Flatten(E.Body);
+            End[I] = Order.size();
+          }
+        }
+      };
+  Flatten(Builder(Graph).run());
+}
+
+}  // namespace dataflow
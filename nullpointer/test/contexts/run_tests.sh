@@ -0,0 +1,53 @@
+#!/bin/bash
+
+# The findings and statistics with call contexts must not depend on the
+# number of threads: run every pass on one thread and on several, a few
+# times, and compare the outputs.
+
+PASS_PLUGIN="../../build/DataflowPass.so"
+RUNS=20
+THREADS=8
+
+FAILED=0
+
+echo "=============================================================="
+echo "| Program   | Pass       | Options               | Result    |"
+echo "|============================================================|"
+
+for c_file in test*.c; do
+    test_name="${c_file%.c}"
+    ll_file="$test_name.ll"
+    opt_file="$test_name.opt.ll"
+
+    clang -emit-llvm -S -fno-discard-value-names -Xclang -disable-O0-optnone \
+          -c -o "$ll_file" "$c_file"
+    opt -mem2reg -S "$ll_file" -o "$opt_file"
+
+    for pass in NullPtr Overflow DivZero Dataflow; do
+        for contexts in 1 2; do
+            options="contexts=$contexts;stats"
+            if ! expected=$(opt -load-pass-plugin="$PASS_PLUGIN" \
+                                -passes="$pass<$options>" "$opt_file" -disable-output 2>&1); then
+                echo "$expected"
+                exit 1
+            fi
+            result="Same"
+            for ((run = 0; run < RUNS; run++)); do
+                output=$(opt -load-pass-plugin="$PASS_PLUGIN" \
+                             -passes="$pass<$options;threads=$THREADS>" "$opt_file" \
+                             -disable-output 2>&1)
+                if [ "$output" != "$expected" ]; then
+                    result="Different"
+                    ((FAILED++))
+                    break
+                fi
+            done
+            printf "| %-9s | %-10s | %-21s | %-9s |\n" \
+                "$c_file" "$pass" "$options" "$result"
+        done
+    done
+done
+
+echo "=============================================================="
+echo "Different outputs: $FAILED"
+[ "$FAILED" -eq 0 ]
@@ -0,0 +1,34 @@
+#include <limits.h>
+
+// Eight callers of the same size, each with a context of its own for g(): a
+// context limit must not depend on which caller runs first.
+int g(int x) {
+  if (x < 10)
+    return 0;
+  return INT_MAX;
+}
+
+int c1(void) { int r = g(1); return r + 1; }
+int c2(void) { int r = g(2); return r + 1; }
+int c3(void) { int r = g(3); return r + 1; }
+int c4(void) { int r = g(4); return r + 1; }
+int c5(void) { int r = g(5); return r + 1; }
+int c6(void) { int r = g(6); return r + 1; }
+int c7(void) { int r = g(7); return r + 1; }
+int c8(void) { int r = g(8); return r + 1; }
+
+// One caller with more contexts than the limit.
+int many(int n) {
+  int r = 0;
+  if (n == 1)
+    r = g(1);
+  else if (n == 2)
+    r = g(2);
+  else
+    r = g(20);
+  return r + 1;
+}
+
+int main(void) {
+  return c1() + c2() + c3() + c4() + c5() + c6() + c7() + c8() + many(0);
+}
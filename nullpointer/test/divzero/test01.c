@@ -0,0 +1,6 @@
+// The divisor is the constant zero.
+int main(void) {
+  int x = 10;
+  int y = 0;
+  return x / y;
+}
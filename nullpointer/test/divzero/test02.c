@@ -0,0 +1,6 @@
+// The division only runs when the divisor is not zero.
+int quotient(int x, int y) {
+  if (y != 0)
+    return x / y;
+  return 0;
+}
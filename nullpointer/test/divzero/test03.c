@@ -0,0 +1,5 @@
+// x - x is always zero.
+int scale(int x, int y) {
+  int d = x - x;
+  return y / d;
+}
@@ -0,0 +1,7 @@
+// 1 / 2 rounds to zero: the quotient of two nonzero values may be zero.
+int main(void) {
+  int a = 1;
+  int b = 2;
+  int q = a / b;
+  return 10 / q;
+}
@@ -0,0 +1,7 @@
+// The product of two nonzero values is not zero.
+int average(int sum) {
+  int a = 3;
+  int b = 5;
+  int d = a * b;
+  return sum / d;
+}
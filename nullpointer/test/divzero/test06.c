@@ -0,0 +1,6 @@
+// A zero divisor returns early.
+int quotient(int x, int y) {
+  if (y == 0)
+    return -1;
+  return x / y;
+}
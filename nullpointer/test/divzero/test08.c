@@ -0,0 +1,4 @@
+// The divisor is an argument, which may be zero.
+int ratio(int x, int y) {
+  return x / y;
+}
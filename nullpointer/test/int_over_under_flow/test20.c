@@ -0,0 +1,10 @@
+// Expect: pass
+#include <limits.h>
+
+int main() {
+    int last = 0;
+    for (int i = 0; i < 1000; i++) {
+        last = i;
+    }
+    return last * 2;
+}
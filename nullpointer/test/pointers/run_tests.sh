@@ -0,0 +1,52 @@
+#!/bin/bash
+
+# Pointer analysis tests: each input runs NullPtr with its pointer analysis.
+# The inputs are written in IR, for shapes clang does not emit.
+
+PASS_PLUGIN="../../build/NullPtrPass.so"
+
+FAILED=0
+
+declare -A ground_truth
+declare -A pointers
+ground_truth["test01.ll"]="right"; pointers["test01.ll"]="flow-sensitive"
+
+echo "====================================================================="
+echo "| Program    | Pointers       | Ground Truth | Detector | Result    |"
+echo "|===================================================================|"
+
+for ll_file in $(printf '%s\n' "${!ground_truth[@]}" | sort); do
+    mode=${pointers[$ll_file]}
+    if ! output=$(opt -load-pass-plugin="$PASS_PLUGIN" -passes="NullPtr<pointers=$mode>" \
+                      "$ll_file" -disable-output 2>&1); then
+        echo "$output"
+        exit 1
+    fi
+
+    trailing=$(echo "$output" | sed -n '/Potential Instructions by NullPtr/,$p' | tail -n +2)
+    if [ -n "$trailing" ] && echo "$trailing" | grep -q '[^[:space:]]'; then
+        detector_result="reject"
+    else
+        detector_result="accept"
+    fi
+
+    expected=${ground_truth[$ll_file]}
+    if [ "$expected" = "wrong" ]; then
+        expected_result="reject"
+    else
+        expected_result="accept"
+    fi
+    if [ "$detector_result" = "$expected_result" ]; then
+        analysis_result="Correct"
+    else
+        analysis_result="Incorrect"
+        ((FAILED++))
+    fi
+
+    printf "| %-10s | %-14s | %-12s | %-8s | %-9s |\n" \
+        "$ll_file" "$mode" "$expected" "$detector_result" "$analysis_result"
+done
+
+echo "====================================================================="
+echo "Incorrect results: $FAILED"
+[ "$FAILED" -eq 0 ]
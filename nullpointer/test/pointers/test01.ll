@@ -0,0 +1,34 @@
+; %s is allocated anew at each iteration, so it is a dynamic alloca, and its
+; address is only used to store and load through it. It first holds %x, which
+; holds null, then %y, which holds %a, before the load: with
+; pointers=flow-sensitive the second store replaces the first (strong
+; update), so %p points to %y only and the load through %q is safe. Clang
+; gives every local a static alloca in the entry block, so this input is
+; written in IR.
+
+define i32 @main(i32 %n) {
+entry:
+  %a = alloca i32, align 4
+  %x = alloca i32*, align 8
+  %y = alloca i32*, align 8
+  store i32* null, i32** %x, align 8
+  store i32* %a, i32** %y, align 8
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %inc, %loop ]
+  %sum = phi i32 [ 0, %entry ], [ %add, %loop ]
+  %s = alloca i32**, align 8
+  store i32** %x, i32*** %s, align 8
+  store i32** %y, i32*** %s, align 8
+  %p = load i32**, i32*** %s, align 8
+  %q = load i32*, i32** %p, align 8
+  %v = load i32, i32* %q, align 4
+  %add = add i32 %sum, %v
+  %inc = add i32 %i, 1
+  %cmp = icmp slt i32 %inc, %n
+  br i1 %cmp, label %loop, label %exit
+
+exit:
+  ret i32 %add
+}
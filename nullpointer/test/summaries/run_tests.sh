@@ -0,0 +1,93 @@
+#!/bin/bash
+
+# Interprocedural tests with summaries: each input runs its pass with
+# summaries, and its findings in main(), which only the summaries of its
+# callees decide, must be as expected. Dataflow with summaries must report
+# the same findings for that pass. C inputs are compiled and promoted to
+# registers; IR inputs, for shapes clang does not emit, are run as they are.
+
+PASS_PLUGIN="../../build/DataflowPass.so"
+
+FAILED=0
+
+declare -A ground_truth
+declare -A pass
+ground_truth["test01.ll"]="right"; pass["test01.ll"]="NullPtr"
+ground_truth["test02.c"]="wrong";  pass["test02.c"]="NullPtr"
+ground_truth["test03.c"]="wrong";  pass["test03.c"]="NullPtr"
+ground_truth["test04.c"]="right";  pass["test04.c"]="Overflow"
+ground_truth["test05.c"]="wrong";  pass["test05.c"]="Overflow"
+ground_truth["test06.c"]="wrong";  pass["test06.c"]="Overflow"
+
+# The findings of pass $2 in main() in the output $1, one instruction per
+# line.
+findings() {
+    echo "$1" | awk -v pass="$2" '
+        /^Running / { main = $NF == "main"; on = 0; next }
+        /^Dataflow Analysis Results:/ { on = 0; next }
+        /^Potential / { on = main && index($0, "by " pass ":") > 0; next }
+        on && /^  [^ ]/'
+}
+
+echo "==========================================================================="
+echo "| Program    | Pass     | Ground Truth | Detector | Dataflow  | Result    |"
+echo "|=========================================================================|"
+
+for input in $(printf '%s\n' "${!ground_truth[@]}" | sort); do
+    test_name="${input%.*}"
+    if [ "${input##*.}" = "c" ]; then
+        ll_file="$test_name.ll"
+        opt_file="$test_name.opt.ll"
+        clang -emit-llvm -S -fno-discard-value-names -Xclang -disable-O0-optnone \
+              -c -o "$ll_file" "$input"
+        opt -mem2reg -S "$ll_file" -o "$opt_file"
+    else
+        opt_file="$input"
+    fi
+
+    test_pass=${pass[$input]}
+    if ! output=$(opt -load-pass-plugin="$PASS_PLUGIN" -passes="$test_pass<summaries>" \
+                      "$opt_file" -disable-output 2>&1); then
+        echo "$output"
+        exit 1
+    fi
+    if ! product=$(opt -load-pass-plugin="$PASS_PLUGIN" -passes="Dataflow<summaries>" \
+                       "$opt_file" -disable-output 2>&1); then
+        echo "$product"
+        exit 1
+    fi
+    found=$(findings "$output" "$test_pass")
+    product_found=$(findings "$product" "$test_pass")
+
+    if [ -n "$found" ]; then
+        detector_result="reject"
+    else
+        detector_result="accept"
+    fi
+    if [ "$found" = "$product_found" ]; then
+        dataflow_result="agrees"
+    else
+        dataflow_result="disagrees"
+    fi
+
+    expected=${ground_truth[$input]}
+    if [ "$expected" = "wrong" ]; then
+        expected_result="reject"
+    else
+        expected_result="accept"
+    fi
+    if [ "$detector_result" = "$expected_result" ] && [ "$dataflow_result" = "agrees" ]; then
+        analysis_result="Correct"
+    else
+        analysis_result="Incorrect"
+        ((FAILED++))
+    fi
+
+    printf "| %-10s | %-8s | %-12s | %-8s | %-9s | %-9s |\n" \
+        "$input" "$test_pass" "$expected" "$detector_result" "$dataflow_result" \
+        "$analysis_result"
+done
+
+echo "==========================================================================="
+echo "Incorrect results: $FAILED"
+[ "$FAILED" -eq 0 ]
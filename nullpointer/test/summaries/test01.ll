@@ -0,0 +1,26 @@
+; The null return of get() sits behind an infeasible edge: an alloca is never
+; null. Its summary must be NonNull, so the load in main() is safe, for NullPtr
+; and for the NullPtr part of Dataflow alike. Clang gives every function a
+; single return block, so this input is written in IR: with two returns, the
+; summary joins the blocks that return, and a block that is never reached must
+; not be among them.
+
+define i32* @get() {
+entry:
+  %a = alloca i32, align 4
+  %cmp = icmp eq i32* %a, null
+  br i1 %cmp, label %if.then, label %if.end
+
+if.then:
+  ret i32* null
+
+if.end:
+  ret i32* %a
+}
+
+define i32 @main() {
+entry:
+  %q = call i32* @get()
+  %v = load i32, i32* %q, align 4
+  ret i32 %v
+}
@@ -0,0 +1,12 @@
+#include <stddef.h>
+
+// none() always returns null: its summary is Null, so the load of its result
+// in main() is flagged.
+int *none(void) {
+  return NULL;
+}
+
+int main(void) {
+  int *p = none();
+  return *p;
+}
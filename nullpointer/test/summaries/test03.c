@@ -0,0 +1,11 @@
+#include <stddef.h>
+
+// get() dereferences its argument without testing it, so the call with a
+// null argument in main() is flagged.
+int get(int *p) {
+  return *p;
+}
+
+int main(void) {
+  return get(NULL);
+}
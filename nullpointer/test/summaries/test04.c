@@ -0,0 +1,13 @@
+// The result of inc() is its argument plus 0 or 1, so inc(10) is in [10, 11]
+// and subtracting 100 from it cannot overflow. Its range alone, for any
+// argument, could.
+int inc(int x) {
+  if (x < 1000)
+    x = x + 1;
+  return x;
+}
+
+int main(void) {
+  int r = inc(10);
+  return r - 100;
+}
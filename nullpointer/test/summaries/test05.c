@@ -0,0 +1,13 @@
+#include <limits.h>
+
+// inc(INT_MAX) is INT_MAX, so adding 1 to it overflows.
+int inc(int x) {
+  if (x < 1000)
+    x = x + 1;
+  return x;
+}
+
+int main(void) {
+  int r = inc(INT_MAX);
+  return r + 1;
+}
@@ -0,0 +1,13 @@
+// twice(n) is 2 to the n: twice(31) overflows, and so does r - 1. twice() is
+// its own caller, so the recursive call has no summary and can return any
+// value; the summary of twice() must not be just the 1 of its base case.
+int twice(int n) {
+  if (n <= 0)
+    return 1;
+  return 2 * twice(n - 1);
+}
+
+int main(void) {
+  int r = twice(31);
+  return r - 1;
+}